@@ -0,0 +1,182 @@
+#ifdef ADVENT_PROFILE_ALLOC
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+#include <sys/resource.h>
+
+#include "alloc_tracking.h"
+
+namespace {
+
+// Constant initialized, so that allocating never runs a constructor
+thread_local AllocationStats threadStats{};
+
+std::atomic<int64_t> processAllocations{0};
+std::atomic<int64_t> processBytes{0};
+std::atomic<int64_t> processLiveBytes{0};
+std::atomic<int64_t> processPeakLiveBytes{0};
+
+void recordAllocation(size_t requested, size_t usable) {
+  // Live bytes count what `malloc` actually handed out, since that is all
+  // that is known again when the memory is freed
+  const int64_t size{static_cast<int64_t>(usable)};
+
+  threadStats.nAllocations++;
+  threadStats.nBytes += static_cast<int64_t>(requested);
+  threadStats.liveBytes += size;
+  threadStats.peakLiveBytes =
+      std::max(threadStats.peakLiveBytes, threadStats.liveBytes);
+
+  processAllocations.fetch_add(1, std::memory_order_relaxed);
+  processBytes.fetch_add(static_cast<int64_t>(requested),
+                         std::memory_order_relaxed);
+  const int64_t live{
+      processLiveBytes.fetch_add(size, std::memory_order_relaxed) + size};
+  int64_t peak{processPeakLiveBytes.load(std::memory_order_relaxed)};
+  while (live > peak && !processPeakLiveBytes.compare_exchange_weak(
+                            peak, live, std::memory_order_relaxed)) {
+  }
+}
+
+void *allocate(size_t size, size_t alignment) {
+  void *memory{nullptr};
+  if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    memory = std::malloc(std::max<size_t>(size, 1));
+  } else {
+    // `aligned_alloc` wants a multiple of the alignment
+    memory = std::aligned_alloc(
+        alignment, (std::max<size_t>(size, 1) + alignment - 1) / alignment *
+                       alignment);
+  }
+
+  if (memory != nullptr) {
+    recordAllocation(size, malloc_usable_size(memory));
+  }
+
+  return memory;
+}
+
+void *allocateOrThrow(size_t size, size_t alignment) {
+  while (true) {
+    void *memory{allocate(size, alignment)};
+    if (memory != nullptr) {
+      return memory;
+    }
+
+    // Give the new-handler a chance to free something up, as `operator new`
+    // is required to
+    std::new_handler handler{std::get_new_handler()};
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+void deallocate(void *memory) {
+  if (memory == nullptr) {
+    return;
+  }
+
+  const int64_t size{static_cast<int64_t>(malloc_usable_size(memory))};
+  threadStats.liveBytes -= size;
+  processLiveBytes.fetch_sub(size, std::memory_order_relaxed);
+
+  std::free(memory);
+}
+
+} // namespace
+
+AllocationStats &threadAllocationStats() { return threadStats; }
+
+AllocationStats processAllocationStats() {
+  return {processAllocations.load(), processBytes.load(),
+          processLiveBytes.load(), processPeakLiveBytes.load()};
+}
+
+int64_t peakRssBytes() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+
+  // Linux reports `ru_maxrss` in KiB
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+}
+
+void *operator new(size_t size) { return allocateOrThrow(size, 0); }
+
+void *operator new[](size_t size) { return allocateOrThrow(size, 0); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size, 0);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size, 0);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+  return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+  return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void *operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+  return allocate(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  return allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *memory) noexcept { deallocate(memory); }
+
+void operator delete[](void *memory) noexcept { deallocate(memory); }
+
+void operator delete(void *memory, size_t) noexcept { deallocate(memory); }
+
+void operator delete[](void *memory, size_t) noexcept { deallocate(memory); }
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept {
+  deallocate(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept {
+  deallocate(memory);
+}
+
+void operator delete(void *memory, std::align_val_t) noexcept {
+  deallocate(memory);
+}
+
+void operator delete[](void *memory, std::align_val_t) noexcept {
+  deallocate(memory);
+}
+
+void operator delete(void *memory, size_t, std::align_val_t) noexcept {
+  deallocate(memory);
+}
+
+void operator delete[](void *memory, size_t, std::align_val_t) noexcept {
+  deallocate(memory);
+}
+
+void operator delete(void *memory, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  deallocate(memory);
+}
+
+void operator delete[](void *memory, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  deallocate(memory);
+}
+
+#endif
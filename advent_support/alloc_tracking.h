@@ -0,0 +1,30 @@
+#pragma once
+
+// Allocation tracking for `make PROFILE=alloc`, which replaces the global
+// `operator new` and `operator delete` with counting versions. The profiler
+// attributes the counts to its spans, see `profiling.h`.
+
+#ifdef ADVENT_PROFILE_ALLOC
+
+#include <cstdint>
+
+struct AllocationStats {
+  int64_t nAllocations;
+  int64_t nBytes;
+  // Bytes allocated minus bytes freed. Memory freed by another thread than
+  // the one that allocated it can make a thread's count negative
+  int64_t liveBytes;
+  // High-water mark of `liveBytes`, which spans reset when they start
+  int64_t peakLiveBytes;
+};
+
+// The allocations of the calling thread
+AllocationStats &threadAllocationStats();
+
+// The allocations of the whole process
+AllocationStats processAllocationStats();
+
+// The peak resident set size of the process so far
+int64_t peakRssBytes();
+
+#endif
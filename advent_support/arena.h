@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+class Arena {
+  /**
+   * A monotonic `std::pmr` memory resource for short-lived parse state.
+   * Allocations bump a pointer into an inline buffer and deallocations are
+   * no-ops; `reset()` reclaims everything at once, so it should be called
+   * per line or per batch once the state allocated from it is destroyed.
+   *
+   * Allocations that outgrow the buffer come from a pool that keeps its
+   * memory across `reset()`s, so a steady state workload stops calling
+   * `malloc` after the first few records.
+   **/
+public:
+  explicit Arena(size_t bufferSize = 64 * 1024)
+      : mBuffer{new std::byte[bufferSize]},
+        mResource{mBuffer.get(), bufferSize, &mOverflow} {}
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  std::pmr::memory_resource *resource() { return &mResource; }
+
+  void reset() { mResource.release(); }
+
+private:
+  std::unique_ptr<std::byte[]> mBuffer;
+  std::pmr::unsynchronized_pool_resource mOverflow{};
+  std::pmr::monotonic_buffer_resource mResource;
+};
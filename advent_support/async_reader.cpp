@@ -0,0 +1,520 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "async_reader.h"
+#include "decompress.h"
+#include "profiling.h"
+#include "thread_pool.h"
+
+namespace {
+
+class FileDescriptor {
+  /**
+   * A read-only file descriptor, closed on destruction.
+   **/
+public:
+  explicit FileDescriptor(const std::string &filename)
+      : mFd{::open(filename.c_str(), O_RDONLY | O_CLOEXEC)} {
+    if (mFd < 0) {
+      throw std::runtime_error("Error opening file: " + filename);
+    }
+  }
+
+  ~FileDescriptor() { ::close(mFd); }
+
+  FileDescriptor(const FileDescriptor &) = delete;
+  FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+  int get() const { return mFd; }
+
+private:
+  int mFd;
+};
+
+int64_t preadFully(int fd, char *buffer, int64_t length, int64_t offset) {
+  // `pread` may return fewer bytes than asked for, keep going until `length`
+  // bytes were read or the file ended
+  int64_t filled{0};
+  while (filled < length) {
+    const ssize_t n{
+        ::pread(fd, buffer + filled, length - filled, offset + filled)};
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "pread");
+    }
+    if (n == 0) {
+      break;
+    }
+    filled += n;
+  }
+
+  return filled;
+}
+
+int64_t readAtLeast(int fd, char *buffer, int64_t minimum, int64_t capacity) {
+  // `read` on a pipe returns whatever is there, keep going until at least
+  // `minimum` bytes were read or the input ended
+  int64_t filled{0};
+  while (filled < minimum) {
+    const ssize_t n{::read(fd, buffer + filled, capacity - filled)};
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "read");
+    }
+    if (n == 0) {
+      break;
+    }
+    filled += n;
+  }
+
+  return filled;
+}
+
+void readSequentially(int fd,
+                      const std::function<void(std::string_view)> &onChunk) {
+  /**
+   * Pipes and the like have no size to split into chunks up front, and can
+   * only be read once, so the compression is detected on the first chunk,
+   * which is read until it holds the magic bytes.
+   **/
+  std::unique_ptr<char[]> buffer{new char[ASYNC_READ_CHUNK_SIZE]};
+
+  const int64_t nHead{readAtLeast(fd, buffer.get(), COMPRESSION_MAGIC_SIZE,
+                                  ASYNC_READ_CHUNK_SIZE)};
+  const Compression compression{
+      detectCompression({buffer.get(), static_cast<size_t>(nHead)})};
+
+  // Each chunk is consumed before the next one is read into the buffer
+  auto readAll{[fd, &buffer, nHead](const ChunkSink &sink) {
+    int64_t n{nHead};
+    while (n > 0) {
+      sink({buffer.get(), static_cast<size_t>(n)});
+      n = readAtLeast(fd, buffer.get(), 1, ASYNC_READ_CHUNK_SIZE);
+    }
+  }};
+
+  if (compression == Compression::NONE) {
+    readAll(onChunk);
+    return;
+  }
+  decompressChunks(compression, readAll, onChunk);
+}
+
+ThreadPool &preadPool() {
+  static ThreadPool pool{ASYNC_READ_QUEUE_DEPTH};
+  return pool;
+}
+
+void readChunksWithPread(
+    int fd, int64_t fileSize,
+    const std::function<void(std::string_view)> &onChunk) {
+  /**
+   * Chunk `k` is read into slot `k % ASYNC_READ_QUEUE_DEPTH`. Once it has
+   * been handed to `onChunk`, its slot moves on to the chunk
+   * `ASYNC_READ_QUEUE_DEPTH` further down the file.
+   **/
+  const int64_t nChunks{(fileSize + ASYNC_READ_CHUNK_SIZE - 1) /
+                        ASYNC_READ_CHUNK_SIZE};
+
+  std::vector<std::unique_ptr<char[]>> buffers(ASYNC_READ_QUEUE_DEPTH);
+  std::vector<std::future<int64_t>> reads(ASYNC_READ_QUEUE_DEPTH);
+
+  // If anything throws, wait for the reads still in flight before their
+  // buffers go away
+  struct DrainReads {
+    std::vector<std::future<int64_t>> &reads;
+    ~DrainReads() {
+      for (std::future<int64_t> &read : reads) {
+        if (read.valid()) {
+          read.wait();
+        }
+      }
+    }
+  } drainReads{reads};
+
+  auto startChunk{[&](int64_t chunk) {
+    const int64_t slot{chunk % ASYNC_READ_QUEUE_DEPTH};
+    if (!buffers[slot]) {
+      buffers[slot].reset(new char[ASYNC_READ_CHUNK_SIZE]);
+    }
+
+    char *buffer{buffers[slot].get()};
+    const int64_t offset{chunk * ASYNC_READ_CHUNK_SIZE};
+    const int64_t length{std::min(ASYNC_READ_CHUNK_SIZE, fileSize - offset)};
+    reads[slot] = preadPool().submit(
+        [=]() { return preadFully(fd, buffer, length, offset); });
+  }};
+
+  for (int64_t chunk{0}; chunk < std::min<int64_t>(ASYNC_READ_QUEUE_DEPTH,
+                                                   nChunks);
+       chunk++) {
+    startChunk(chunk);
+  }
+
+  for (int64_t chunk{0}; chunk < nChunks; chunk++) {
+    const int64_t slot{chunk % ASYNC_READ_QUEUE_DEPTH};
+    const int64_t n{reads[slot].get()};
+    onChunk({buffers[slot].get(), static_cast<size_t>(n)});
+
+    if (chunk + ASYNC_READ_QUEUE_DEPTH < nChunks) {
+      startChunk(chunk + ASYNC_READ_QUEUE_DEPTH);
+    }
+  }
+}
+
+class IoUring {
+  /**
+   * A minimal io_uring instance on top of the raw system calls, so that
+   * liburing is not needed. Only the owning thread submits and reaps.
+   **/
+public:
+  explicit IoUring(uint32_t nEntries) {
+    io_uring_params params{};
+    mFd = static_cast<int>(::syscall(__NR_io_uring_setup, nEntries, &params));
+    if (mFd < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "io_uring_setup");
+    }
+
+    mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap{(params.features & IORING_FEAT_SINGLE_MMAP) != 0};
+    if (singleMmap) {
+      mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+    }
+    mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+    mSqRing = map(mSqRingSize, IORING_OFF_SQ_RING);
+    mCqRing = singleMmap ? mSqRing : map(mCqRingSize, IORING_OFF_CQ_RING);
+    mSqes = static_cast<io_uring_sqe *>(map(mSqesSize, IORING_OFF_SQES));
+
+    char *sqRing{static_cast<char *>(mSqRing)};
+    mSqTail = reinterpret_cast<unsigned *>(sqRing + params.sq_off.tail);
+    mSqMask = reinterpret_cast<unsigned *>(sqRing + params.sq_off.ring_mask);
+    mSqArray = reinterpret_cast<unsigned *>(sqRing + params.sq_off.array);
+
+    char *cqRing{static_cast<char *>(mCqRing)};
+    mCqHead = reinterpret_cast<unsigned *>(cqRing + params.cq_off.head);
+    mCqTail = reinterpret_cast<unsigned *>(cqRing + params.cq_off.tail);
+    mCqMask = reinterpret_cast<unsigned *>(cqRing + params.cq_off.ring_mask);
+    mCqes = reinterpret_cast<io_uring_cqe *>(cqRing + params.cq_off.cqes);
+  }
+
+  ~IoUring() { release(); }
+
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  // Queue a read of `iov` from `offset` of `fd`. `iov` has to stay alive
+  // until the read completes
+  void submitRead(int fd, const iovec *iov, uint64_t offset,
+                  uint64_t userData) {
+    // Only this thread moves the tail, so a plain load is enough
+    const unsigned tail{*mSqTail};
+    const unsigned index{tail & *mSqMask};
+
+    // `IORING_OP_READV` rather than `IORING_OP_READ`, which needs Linux 5.6
+    io_uring_sqe &sqe{mSqes[index]};
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READV;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<uint64_t>(iov);
+    sqe.len = 1;
+    sqe.off = offset;
+    sqe.user_data = userData;
+
+    mSqArray[index] = index;
+    __atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+
+    enter(1, 0, 0);
+  }
+
+  // Wait for the next completion, returning its `userData` and result
+  std::pair<uint64_t, int32_t> waitCompletion() {
+    while (true) {
+      const unsigned head{*mCqHead};
+      if (head != __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE)) {
+        const io_uring_cqe &cqe{mCqes[head & *mCqMask]};
+        const std::pair<uint64_t, int32_t> completion{cqe.user_data, cqe.res};
+        __atomic_store_n(mCqHead, head + 1, __ATOMIC_RELEASE);
+
+        return completion;
+      }
+
+      enter(0, 1, IORING_ENTER_GETEVENTS);
+    }
+  }
+
+private:
+  void *map(size_t size, off_t offset) {
+    void *mapping{::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, mFd, offset)};
+    if (mapping == MAP_FAILED) {
+      const int error{errno};
+      release();
+      throw std::system_error(error, std::generic_category(), "mmap");
+    }
+
+    return mapping;
+  }
+
+  void enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    while (::syscall(__NR_io_uring_enter, mFd, toSubmit, minComplete, flags,
+                     nullptr, 0) < 0) {
+      if (errno != EINTR) {
+        throw std::system_error(errno, std::generic_category(),
+                                "io_uring_enter");
+      }
+    }
+  }
+
+  void release() {
+    if (mSqes != nullptr) {
+      ::munmap(mSqes, mSqesSize);
+    }
+    if (mCqRing != nullptr && mCqRing != mSqRing) {
+      ::munmap(mCqRing, mCqRingSize);
+    }
+    if (mSqRing != nullptr) {
+      ::munmap(mSqRing, mSqRingSize);
+    }
+    if (mFd >= 0) {
+      ::close(mFd);
+    }
+
+    mSqes = nullptr;
+    mCqRing = mSqRing = nullptr;
+    mFd = -1;
+  }
+
+  int mFd{-1};
+  void *mSqRing{nullptr};
+  void *mCqRing{nullptr};
+  io_uring_sqe *mSqes{nullptr};
+  size_t mSqRingSize{0};
+  size_t mCqRingSize{0};
+  size_t mSqesSize{0};
+
+  unsigned *mSqTail{nullptr};
+  unsigned *mSqMask{nullptr};
+  unsigned *mSqArray{nullptr};
+  unsigned *mCqHead{nullptr};
+  unsigned *mCqTail{nullptr};
+  unsigned *mCqMask{nullptr};
+  io_uring_cqe *mCqes{nullptr};
+};
+
+void readChunksWithIoUring(
+    IoUring &ring, int fd, int64_t fileSize,
+    const std::function<void(std::string_view)> &onChunk) {
+  /**
+   * Same slot scheme as `readChunksWithPread`. Completions arrive in any
+   * order, so a slot is only handed over once every chunk before it was.
+   **/
+  struct Slot {
+    std::unique_ptr<char[]> buffer{};
+    iovec iov{};
+    int64_t offset{0};
+    int64_t length{0};
+    int64_t filled{0};
+    bool done{false};
+  };
+
+  const int64_t nChunks{(fileSize + ASYNC_READ_CHUNK_SIZE - 1) /
+                        ASYNC_READ_CHUNK_SIZE};
+  std::vector<Slot> slots(ASYNC_READ_QUEUE_DEPTH);
+  int32_t nInFlight{0};
+
+  auto submitRemainder{[&](int64_t slotId) {
+    Slot &slot{slots[slotId]};
+    slot.iov.iov_base = slot.buffer.get() + slot.filled;
+    slot.iov.iov_len = static_cast<size_t>(slot.length - slot.filled);
+    ring.submitRead(fd, &slot.iov, slot.offset + slot.filled, slotId);
+    nInFlight++;
+  }};
+
+  auto startChunk{[&](int64_t chunk) {
+    const int64_t slotId{chunk % ASYNC_READ_QUEUE_DEPTH};
+    Slot &slot{slots[slotId]};
+    if (!slot.buffer) {
+      slot.buffer.reset(new char[ASYNC_READ_CHUNK_SIZE]);
+    }
+
+    slot.offset = chunk * ASYNC_READ_CHUNK_SIZE;
+    slot.length = std::min(ASYNC_READ_CHUNK_SIZE, fileSize - slot.offset);
+    slot.filled = 0;
+    slot.done = false;
+    submitRemainder(slotId);
+  }};
+
+  try {
+    for (int64_t chunk{0};
+         chunk < std::min<int64_t>(ASYNC_READ_QUEUE_DEPTH, nChunks); chunk++) {
+      startChunk(chunk);
+    }
+
+    int64_t nextChunk{0};
+    while (nextChunk < nChunks) {
+      Slot &next{slots[nextChunk % ASYNC_READ_QUEUE_DEPTH]};
+
+      if (next.done) {
+        onChunk({next.buffer.get(), static_cast<size_t>(next.filled)});
+        if (nextChunk + ASYNC_READ_QUEUE_DEPTH < nChunks) {
+          startChunk(nextChunk + ASYNC_READ_QUEUE_DEPTH);
+        }
+        nextChunk++;
+        continue;
+      }
+
+      const auto [slotId, result]{ring.waitCompletion()};
+      nInFlight--;
+      Slot &slot{slots[slotId]};
+
+      if (result == -EINTR || result == -EAGAIN) {
+        submitRemainder(slotId);
+      } else if (result < 0) {
+        throw std::system_error(-result, std::generic_category(),
+                                "io_uring read");
+      } else {
+        // Short reads are continued, a read of 0 bytes means the file shrank
+        slot.filled += result;
+        if (result > 0 && slot.filled < slot.length) {
+          submitRemainder(slotId);
+        } else {
+          slot.done = true;
+        }
+      }
+    }
+  } catch (...) {
+    // The kernel may still be writing into the buffers
+    try {
+      for (; nInFlight > 0; nInFlight--) {
+        ring.waitCompletion();
+      }
+    } catch (const std::system_error &) {
+      // Nothing left to wait for that we could wait for
+    }
+    throw;
+  }
+}
+
+bool ioUringAvailable() {
+  static const bool available{[]() {
+    const char *backendEnv{std::getenv("ADVENT_IO_BACKEND")};
+    if (backendEnv != nullptr && std::string{backendEnv} == "pread") {
+      return false;
+    }
+
+    // Seccomp filters (containers) and old kernels refuse io_uring
+    try {
+      IoUring probe{ASYNC_READ_QUEUE_DEPTH};
+      return true;
+    } catch (const std::system_error &) {
+      return false;
+    }
+  }()};
+
+  return available;
+}
+
+void readRegularFile(int fd, const int64_t fileSize,
+                     const std::function<void(std::string_view)> &onChunk) {
+  // A single chunk gains nothing from being read asynchronously
+  if (fileSize <= ASYNC_READ_CHUNK_SIZE) {
+    std::unique_ptr<char[]> buffer{new char[std::max<int64_t>(fileSize, 1)]};
+    const int64_t n{preadFully(fd, buffer.get(), fileSize, 0)};
+    if (n > 0) {
+      onChunk({buffer.get(), static_cast<size_t>(n)});
+    }
+    return;
+  }
+
+  if (ioUringAvailable()) {
+    // Setting up a ring can still fail, e.g. on `RLIMIT_MEMLOCK`
+    std::unique_ptr<IoUring> ring;
+    try {
+      ring = std::make_unique<IoUring>(ASYNC_READ_QUEUE_DEPTH);
+    } catch (const std::system_error &) {
+    }
+
+    if (ring) {
+      readChunksWithIoUring(*ring, fd, fileSize, onChunk);
+      return;
+    }
+  }
+
+  readChunksWithPread(fd, fileSize, onChunk);
+}
+
+} // namespace
+
+void readFileChunks(const std::string &filename,
+                    const std::function<void(std::string_view)> &onChunk) {
+  ADVENT_PROFILE_SCOPE("readFileChunks");
+  const FileDescriptor file{filename};
+
+  auto countedOnChunk{[&onChunk](std::string_view chunk) {
+    ADVENT_PROFILE_COUNT("io.bytesRead", chunk.size());
+    ADVENT_PROFILE_COUNT("io.chunksRead", 1);
+    onChunk(chunk);
+  }};
+
+  struct stat status{};
+  if (::fstat(file.get(), &status) != 0) {
+    throw std::system_error(errno, std::generic_category(), "fstat");
+  }
+
+  if (!S_ISREG(status.st_mode)) {
+    readSequentially(file.get(), countedOnChunk);
+    return;
+  }
+
+  const int64_t fileSize{status.st_size};
+
+  char magic[COMPRESSION_MAGIC_SIZE];
+  const int64_t nMagic{preadFully(file.get(), magic, sizeof(magic), 0)};
+  const Compression compression{detectCompression(
+      {magic, static_cast<size_t>(nMagic)})};
+
+  if (compression == Compression::NONE) {
+    readRegularFile(file.get(), fileSize, countedOnChunk);
+    return;
+  }
+
+  // The compressed chunks are still read asynchronously, the decompression
+  // thread consumes them as they land
+  decompressChunks(
+      compression,
+      [&file, fileSize](const ChunkSink &onCompressed) {
+        readRegularFile(file.get(), fileSize, onCompressed);
+      },
+      countedOnChunk);
+}
+
+const char *asyncReadBackend() {
+  return ioUringAvailable() ? "io_uring" : "pread";
+}
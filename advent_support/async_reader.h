@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Asynchronous whole-file reads. Several large reads are kept in flight, and
+// each chunk is handed over as soon as it and every chunk before it landed,
+// so the caller can parse the start of a file while the rest is still read.
+//
+// Reads go through io_uring where the kernel allows it, and through a pool of
+// `pread` threads otherwise. `ADVENT_IO_BACKEND=pread` forces the latter.
+//
+// gzip and zstd files are recognized by their magic bytes and decompressed
+// on the fly, see `decompress.h`.
+
+constexpr int64_t ASYNC_READ_CHUNK_SIZE{1 << 20};
+constexpr int32_t ASYNC_READ_QUEUE_DEPTH{8};
+
+// Call `onChunk` with each chunk of `filename`, in file order, decompressed if
+// it is compressed. The chunk's memory is reused once `onChunk` returns
+void readFileChunks(const std::string &filename,
+                    const std::function<void(std::string_view)> &onChunk);
+
+// The backend `readFileChunks` uses, `"io_uring"` or `"pread"`
+const char *asyncReadBackend();
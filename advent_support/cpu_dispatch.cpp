@@ -0,0 +1,1016 @@
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#ifdef __x86_64__
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#include "cpu_dispatch.h"
+
+namespace {
+
+CpuLevel detectCpuLevel() {
+#ifdef __x86_64__
+  unsigned eax{0};
+  unsigned ebx{0};
+  unsigned ecx{0};
+  unsigned edx{0};
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_2)) {
+    return CpuLevel::BASELINE;
+  }
+
+  // The wider registers are only usable if the OS saves them on context
+  // switches, which it reports in XCR0
+  if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+    return CpuLevel::SSE42;
+  }
+  unsigned xcr0Low{0};
+  unsigned xcr0High{0};
+  __asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+  const uint64_t xcr0{(static_cast<uint64_t>(xcr0High) << 32) | xcr0Low};
+
+  const uint64_t XCR0_AVX{0x6};
+  const uint64_t XCR0_AVX512{0xe0};
+  if ((xcr0 & XCR0_AVX) != XCR0_AVX ||
+      !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_AVX2)) {
+    return CpuLevel::SSE42;
+  }
+
+  if ((xcr0 & XCR0_AVX512) == XCR0_AVX512 && (ebx & bit_AVX512F) &&
+      (ebx & bit_AVX512BW)) {
+    return CpuLevel::AVX512;
+  }
+
+  return CpuLevel::AVX2;
+#else
+  return CpuLevel::BASELINE;
+#endif
+}
+
+template <typename Kernel>
+Kernel selectKernel(Kernel baseline, [[maybe_unused]] Kernel sse42,
+                    [[maybe_unused]] Kernel avx2,
+                    [[maybe_unused]] Kernel avx512) {
+#ifdef __x86_64__
+  switch (cpuLevel()) {
+  case CpuLevel::AVX512:
+    return avx512;
+  case CpuLevel::AVX2:
+    return avx2;
+  case CpuLevel::SSE42:
+    return sse42;
+  case CpuLevel::BASELINE:
+    break;
+  }
+#endif
+
+  return baseline;
+}
+
+bool isDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+// The spelled digits, from 1
+constexpr std::string_view SPELLED_DIGITS[]{
+    "one", "two", "three", "four", "five", "six", "seven", "eight", "nine"};
+
+// Rows past each column of the transposed lines that the longest spelled
+// digit is compared with
+constexpr int64_t SPELLED_DIGIT_PADDING{4};
+
+// Columns of the lines transposed at a time. A chunk of 64 lanes takes 5 KiB,
+// which stays in L1
+constexpr int64_t TRANSPOSE_CHUNK_COLUMNS{64};
+
+// Rows of a transposed chunk: its columns, and a block of 16 more for the
+// spelled digits starting in its last columns
+constexpr int64_t TRANSPOSE_CHUNK_ROWS{TRANSPOSE_CHUNK_COLUMNS + 16};
+static_assert(TRANSPOSE_CHUNK_ROWS - TRANSPOSE_CHUNK_COLUMNS >=
+              SPELLED_DIGIT_PADDING);
+
+int64_t longestLine(const std::string_view *lines, int32_t nLines) {
+  int64_t retLength{0};
+  for (int32_t lane{0}; lane < nLines; lane++) {
+    retLength = std::max<int64_t>(retLength, lines[lane].size());
+  }
+
+  return retLength;
+}
+
+// Digit masks of up to 64 bytes, bit `i` is set if `data[i]` is a digit
+using DigitMaskKernel = uint64_t (*)(const char *data, int64_t size);
+
+int64_t decodeNumbersWith(DigitMaskKernel digitMask, const char *data,
+                          int64_t size, int32_t *retNumbers,
+                          int64_t capacity) {
+  /**
+   * Only the digits are visited, each block's mask tells where they are.
+   * Numbers may straddle blocks, so the current one carries over.
+   **/
+  int64_t nNumbers{0};
+  int64_t previousDigit{-2};
+  int64_t value{0};
+
+  for (int64_t offset{0}; offset < size; offset += 64) {
+    uint64_t mask{
+        digitMask(data + offset, std::min<int64_t>(64, size - offset))};
+
+    while (mask != 0) {
+      const int64_t position{offset + std::countr_zero(mask)};
+      mask &= mask - 1;
+
+      // A gap since the previous digit ends the number before it
+      if (position != previousDigit + 1 && previousDigit >= 0) {
+        if (nNumbers < capacity) {
+          retNumbers[nNumbers] = static_cast<int32_t>(value);
+        }
+        nNumbers++;
+        value = 0;
+      }
+
+      value = value * 10 + (data[position] - '0');
+      previousDigit = position;
+    }
+  }
+
+  if (previousDigit >= 0) {
+    if (nNumbers < capacity) {
+      retNumbers[nNumbers] = static_cast<int32_t>(value);
+    }
+    nNumbers++;
+  }
+
+  return nNumbers;
+}
+
+/* Baseline */
+
+DigitBounds findDigitBoundsScalar(const char *data, int64_t size) {
+  DigitBounds retBounds{-1, -1};
+
+  for (int64_t i{0}; i < size; i++) {
+    if (isDigit(data[i])) {
+      retBounds.first = i;
+      break;
+    }
+  }
+  for (int64_t i{size - 1}; i >= 0; i--) {
+    if (isDigit(data[i])) {
+      retBounds.last = i;
+      break;
+    }
+  }
+
+  return retBounds;
+}
+
+void findSpelledDigitsScalar(const std::string_view *lines, int32_t nLines,
+                             int8_t *retFirst, int8_t *retLast) {
+  for (int32_t i{0}; i < nLines; i++) {
+    const std::string_view line{lines[i]};
+    retFirst[i] = -1;
+    retLast[i] = -1;
+
+    for (size_t column{0}; column < line.size(); column++) {
+      int8_t digit{-1};
+      if (isDigit(line[column])) {
+        digit = static_cast<int8_t>(line[column] - '0');
+      } else {
+        for (int8_t word{0}; word < 9; word++) {
+          if (line.substr(column).starts_with(SPELLED_DIGITS[word])) {
+            digit = word + 1;
+            break;
+          }
+        }
+      }
+
+      if (digit >= 0) {
+        retFirst[i] = retFirst[i] < 0 ? digit : retFirst[i];
+        retLast[i] = digit;
+      }
+    }
+  }
+}
+
+uint64_t digitMaskScalar(const char *data, int64_t size) {
+  uint64_t retMask{0};
+  for (int64_t i{0}; i < size; i++) {
+    retMask |= static_cast<uint64_t>(isDigit(data[i])) << i;
+  }
+
+  return retMask;
+}
+
+int64_t decodeNumbersScalar(const char *data, int64_t size,
+                            int32_t *retNumbers, int64_t capacity) {
+  return decodeNumbersWith(digitMaskScalar, data, size, retNumbers, capacity);
+}
+
+int64_t findContainingRangeScalar(const int64_t *starts, const int64_t *ends,
+                                  int64_t n, int64_t value) {
+  for (int64_t i{0}; i < n; i++) {
+    if (value >= starts[i] && value < ends[i]) {
+      return i;
+    }
+  }
+
+  return n;
+}
+
+MaskedSums sumWithinLimitsScalar(const int32_t *x, const int32_t *y,
+                                 const int32_t *z, const int64_t *first,
+                                 const int64_t *second, int64_t n,
+                                 int32_t xLimit, int32_t yLimit,
+                                 int32_t zLimit) {
+  MaskedSums retSums{0, 0};
+  for (int64_t i{0}; i < n; i++) {
+    if (x[i] <= xLimit && y[i] <= yLimit && z[i] <= zLimit) {
+      retSums.first += first[i];
+      retSums.second += second[i];
+    }
+  }
+
+  return retSums;
+}
+
+#ifdef __x86_64__
+
+/* SSE4.2 */
+
+__attribute__((target("sse4.2"))) __m128i loadPartial128(const char *data,
+                                                          int64_t size) {
+  // Never read past `data + size`, which may be the end of a page
+  if (size >= 16) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+  }
+
+  char buffer[16]{};
+  std::memcpy(buffer, data, size);
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer));
+}
+
+// The column each row of `transposeBlock` ends up holding
+constexpr int32_t TRANSPOSED_COLUMNS[16]{0, 8, 4, 12, 2, 10, 6, 14,
+                                         1, 9, 5, 13, 3, 11, 7, 15};
+
+__attribute__((target("sse4.2"))) void transposeBlock(__m128i (&rows)[16]) {
+  /**
+   * Transpose 16 rows of 16 bytes in registers, with four rounds of
+   * interleaving pairs of rows, each moving elements twice as large as the
+   * one before. Row `k` ends up as column `TRANSPOSED_COLUMNS[k]`.
+   **/
+  __m128i interleaved[16];
+  for (int32_t i{0}; i < 8; i++) {
+    interleaved[i] = _mm_unpacklo_epi8(rows[2 * i], rows[2 * i + 1]);
+    interleaved[i + 8] = _mm_unpackhi_epi8(rows[2 * i], rows[2 * i + 1]);
+  }
+  for (int32_t i{0}; i < 8; i++) {
+    rows[i] = _mm_unpacklo_epi16(interleaved[2 * i], interleaved[2 * i + 1]);
+    rows[i + 8] =
+        _mm_unpackhi_epi16(interleaved[2 * i], interleaved[2 * i + 1]);
+  }
+  for (int32_t i{0}; i < 8; i++) {
+    interleaved[i] = _mm_unpacklo_epi32(rows[2 * i], rows[2 * i + 1]);
+    interleaved[i + 8] = _mm_unpackhi_epi32(rows[2 * i], rows[2 * i + 1]);
+  }
+  for (int32_t i{0}; i < 8; i++) {
+    rows[i] = _mm_unpacklo_epi64(interleaved[2 * i], interleaved[2 * i + 1]);
+    rows[i + 8] =
+        _mm_unpackhi_epi64(interleaved[2 * i], interleaved[2 * i + 1]);
+  }
+}
+
+__attribute__((target("sse4.2"))) void
+transposeChunk(const std::string_view *lines, int32_t nLines,
+               int32_t laneWidth, int64_t firstColumn, char *retRows) {
+  /**
+   * Lay columns [firstColumn, firstColumn + TRANSPOSE_CHUNK_ROWS) of the
+   * lines out as `laneWidth` byte rows of `retRows`, row `p` holding byte
+   * `firstColumn + p` of every line, transposing 16 lines by 16 columns at a
+   * time. Nothing is cleared up front: each lane's length masks the bytes
+   * past the end of its line to zero, which are neither digits nor letters.
+   **/
+  // The last bytes of a line, when fewer than 16 are left. The rest of it is
+  // masked
+  char tail[16]{};
+
+  for (int32_t laneGroup{0}; laneGroup < laneWidth; laneGroup += 16) {
+    // The bytes each lane has from `firstColumn` on, beyond the chunk's rows
+    // any count will do
+    alignas(16) int8_t remaining[16];
+    for (int32_t i{0}; i < 16; i++) {
+      const int32_t lane{laneGroup + i};
+      const int64_t size{
+          lane < nLines ? static_cast<int64_t>(lines[lane].size()) : 0};
+      remaining[i] = static_cast<int8_t>(
+          std::clamp<int64_t>(size - firstColumn, 0, INT8_MAX));
+    }
+    const __m128i laneLengths{
+        _mm_load_si128(reinterpret_cast<const __m128i *>(remaining))};
+
+    for (int64_t block{0}; block < TRANSPOSE_CHUNK_ROWS; block += 16) {
+      __m128i rows[16];
+      for (int32_t i{0}; i < 16; i++) {
+        const int64_t available{remaining[i] - block};
+        if (available <= 0) {
+          rows[i] = _mm_setzero_si128();
+          continue;
+        }
+
+        const char *data{lines[laneGroup + i].data() + firstColumn + block};
+        if (available < 16) {
+          std::memcpy(tail, data, available);
+          data = tail;
+        }
+        rows[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+      }
+
+      transposeBlock(rows);
+      for (int32_t k{0}; k < 16; k++) {
+        const int64_t row{block + TRANSPOSED_COLUMNS[k]};
+        const __m128i inLine{_mm_cmpgt_epi8(
+            laneLengths, _mm_set1_epi8(static_cast<char>(row)))};
+        _mm_store_si128(
+            reinterpret_cast<__m128i *>(retRows + row * laneWidth + laneGroup),
+            _mm_and_si128(rows[k], inLine));
+      }
+    }
+  }
+}
+
+__attribute__((target("sse4.2"))) __m128i digitRange() {
+  // `pcmpestri` ranges operand matching '0' to '9'
+  return _mm_setr_epi8('0', '9', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+}
+
+__attribute__((target("sse4.2"))) void
+findSpelledDigitsSse42(const std::string_view *lines, int32_t nLines,
+                       int8_t *retFirst, int8_t *retLast) {
+  /**
+   * 16 lines at a time. Each lane holds the digit found at its column plus
+   * one, so that 0 means none: a digit is `c - '0' + 1`, and a spelled digit
+   * ANDs the comparisons of its letters with the columns below.
+   **/
+  constexpr int32_t laneWidth{16};
+  alignas(64) char rows[TRANSPOSE_CHUNK_ROWS * laneWidth];
+
+  for (int32_t group{0}; group < nLines; group += laneWidth) {
+    const int32_t nLanes{std::min(laneWidth, nLines - group)};
+    const int64_t length{longestLine(lines + group, nLanes)};
+
+    const __m128i zero{_mm_setzero_si128()};
+    __m128i first{zero};
+    __m128i last{zero};
+    for (int64_t column{0}; column < length; column++) {
+      // The next chunk is transposed once the previous one was scanned
+      const int64_t row{column % TRANSPOSE_CHUNK_COLUMNS};
+      if (row == 0) {
+        transposeChunk(lines + group, nLanes, laneWidth, column, rows);
+      }
+
+      __m128i letters[SPELLED_DIGIT_PADDING + 1];
+      for (int64_t k{0}; k <= SPELLED_DIGIT_PADDING; k++) {
+        letters[k] = _mm_load_si128(
+            reinterpret_cast<const __m128i *>(rows + (row + k) * laneWidth));
+      }
+
+      const __m128i shifted{_mm_sub_epi8(letters[0], _mm_set1_epi8('0'))};
+      const __m128i isDigit{
+          _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(9)), shifted)};
+      __m128i found{
+          _mm_and_si128(isDigit, _mm_add_epi8(shifted, _mm_set1_epi8(1)))};
+
+      for (int32_t word{0}; word < 9; word++) {
+        const std::string_view spelled{SPELLED_DIGITS[word]};
+        __m128i match{_mm_cmpeq_epi8(letters[0], _mm_set1_epi8(spelled[0]))};
+        for (size_t k{1}; k < spelled.size(); k++) {
+          match = _mm_and_si128(
+              match, _mm_cmpeq_epi8(letters[k], _mm_set1_epi8(spelled[k])));
+        }
+        found = _mm_or_si128(found,
+                             _mm_and_si128(match, _mm_set1_epi8(word + 2)));
+      }
+
+      const __m128i none{_mm_cmpeq_epi8(found, zero)};
+      first = _mm_blendv_epi8(first, found, _mm_cmpeq_epi8(first, zero));
+      last = _mm_blendv_epi8(found, last, none);
+    }
+
+    alignas(16) int8_t firstLanes[laneWidth];
+    alignas(16) int8_t lastLanes[laneWidth];
+    _mm_store_si128(reinterpret_cast<__m128i *>(firstLanes), first);
+    _mm_store_si128(reinterpret_cast<__m128i *>(lastLanes), last);
+    for (int32_t lane{0}; lane < nLanes; lane++) {
+      retFirst[group + lane] = firstLanes[lane] - 1;
+      retLast[group + lane] = lastLanes[lane] - 1;
+    }
+  }
+}
+
+__attribute__((target("sse4.2"))) DigitBounds
+findDigitBoundsSse42(const char *data, int64_t size) {
+  constexpr int FIRST{_SIDD_UBYTE_OPS | _SIDD_CMP_RANGES |
+                      _SIDD_LEAST_SIGNIFICANT};
+  constexpr int LAST{_SIDD_UBYTE_OPS | _SIDD_CMP_RANGES |
+                     _SIDD_MOST_SIGNIFICANT};
+  DigitBounds retBounds{-1, -1};
+
+  for (int64_t offset{0}; offset < size; offset += 16) {
+    const int length{static_cast<int>(std::min<int64_t>(16, size - offset))};
+    const int index{_mm_cmpestri(digitRange(), 2,
+                                 loadPartial128(data + offset, length), length,
+                                 FIRST)};
+    if (index < length) {
+      retBounds.first = offset + index;
+      break;
+    }
+  }
+
+  for (int64_t end{size}; end > 0; end -= 16) {
+    const int64_t begin{std::max<int64_t>(0, end - 16)};
+    const int length{static_cast<int>(end - begin)};
+    const int index{_mm_cmpestri(digitRange(), 2,
+                                 loadPartial128(data + begin, length), length,
+                                 LAST)};
+    if (index < length) {
+      retBounds.last = begin + index;
+      break;
+    }
+  }
+
+  return retBounds;
+}
+
+__attribute__((target("sse4.2"))) uint64_t digitMaskSse42(const char *data,
+                                                           int64_t size) {
+  constexpr int MASK{_SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_BIT_MASK};
+  uint64_t retMask{0};
+
+  for (int64_t offset{0}; offset < size; offset += 16) {
+    const int length{static_cast<int>(std::min<int64_t>(16, size - offset))};
+    const __m128i mask{_mm_cmpestrm(digitRange(), 2,
+                                    loadPartial128(data + offset, length),
+                                    length, MASK)};
+    retMask |= static_cast<uint64_t>(_mm_cvtsi128_si32(mask) & 0xffff)
+               << offset;
+  }
+
+  return retMask;
+}
+
+int64_t decodeNumbersSse42(const char *data, int64_t size, int32_t *retNumbers,
+                           int64_t capacity) {
+  return decodeNumbersWith(digitMaskSse42, data, size, retNumbers, capacity);
+}
+
+__attribute__((target("sse4.2"))) int64_t
+findContainingRangeSse42(const int64_t *starts, const int64_t *ends,
+                         int64_t n, int64_t value) {
+  const __m128i values{_mm_set1_epi64x(value)};
+
+  int64_t i{0};
+  for (; i + 2 <= n; i += 2) {
+    const __m128i start{
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(starts + i))};
+    const __m128i end{
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(ends + i))};
+
+    // start <= value < end, i.e. !(start > value) && end > value
+    const __m128i contains{_mm_andnot_si128(_mm_cmpgt_epi64(start, values),
+                                            _mm_cmpgt_epi64(end, values))};
+    const int mask{_mm_movemask_pd(_mm_castsi128_pd(contains))};
+    if (mask != 0) {
+      return i + std::countr_zero(static_cast<unsigned>(mask));
+    }
+  }
+
+  return i + findContainingRangeScalar(starts + i, ends + i, n - i, value);
+}
+
+__attribute__((target("sse4.2"))) __m128i load128(const void *data) {
+  return _mm_loadu_si128(static_cast<const __m128i *>(data));
+}
+
+__attribute__((target("sse4.2"))) MaskedSums
+sumWithinLimitsSse42(const int32_t *x, const int32_t *y, const int32_t *z,
+                     const int64_t *first, const int64_t *second, int64_t n,
+                     int32_t xLimit, int32_t yLimit, int32_t zLimit) {
+  const __m128i xLimits{_mm_set1_epi32(xLimit)};
+  const __m128i yLimits{_mm_set1_epi32(yLimit)};
+  const __m128i zLimits{_mm_set1_epi32(zLimit)};
+  __m128i firstSums{_mm_setzero_si128()};
+  __m128i secondSums{_mm_setzero_si128()};
+
+  int64_t i{0};
+  for (; i + 4 <= n; i += 4) {
+    // Any value above its limit sets the lane
+    const __m128i above{_mm_or_si128(
+        _mm_or_si128(_mm_cmpgt_epi32(load128(x + i), xLimits),
+                     _mm_cmpgt_epi32(load128(y + i), yLimits)),
+        _mm_cmpgt_epi32(load128(z + i), zLimits))};
+
+    // Widen the four 32-bit lanes to two pairs of 64-bit lanes
+    const __m128i aboveLow{_mm_cvtepi32_epi64(above)};
+    const __m128i aboveHigh{_mm_cvtepi32_epi64(_mm_srli_si128(above, 8))};
+
+    firstSums = _mm_add_epi64(
+        firstSums, _mm_add_epi64(_mm_andnot_si128(aboveLow, load128(first + i)),
+                                 _mm_andnot_si128(aboveHigh,
+                                                  load128(first + i + 2))));
+    secondSums = _mm_add_epi64(
+        secondSums,
+        _mm_add_epi64(_mm_andnot_si128(aboveLow, load128(second + i)),
+                      _mm_andnot_si128(aboveHigh, load128(second + i + 2))));
+  }
+
+  MaskedSums retSums{sumWithinLimitsScalar(x + i, y + i, z + i, first + i,
+                                           second + i, n - i, xLimit, yLimit,
+                                           zLimit)};
+  retSums.first += _mm_extract_epi64(firstSums, 0) +
+                   _mm_extract_epi64(firstSums, 1);
+  retSums.second += _mm_extract_epi64(secondSums, 0) +
+                    _mm_extract_epi64(secondSums, 1);
+  return retSums;
+}
+
+/* AVX2 */
+
+__attribute__((target("avx2"))) uint32_t digitMask32(const char *data) {
+  const __m256i chunk{
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data))};
+
+  // Unsigned `c - '0' <= 9`, as `min(c - '0', 9) == c - '0'`
+  const __m256i shifted{_mm256_sub_epi8(chunk, _mm256_set1_epi8('0'))};
+  const __m256i isDigit{_mm256_cmpeq_epi8(
+      _mm256_min_epu8(shifted, _mm256_set1_epi8(9)), shifted)};
+
+  return static_cast<uint32_t>(_mm256_movemask_epi8(isDigit));
+}
+
+__attribute__((target("avx2"))) void
+findSpelledDigitsAvx2(const std::string_view *lines, int32_t nLines,
+                       int8_t *retFirst, int8_t *retLast) {
+  /**
+   * 32 lines at a time, the same way as `findSpelledDigitsSse42`.
+   **/
+  constexpr int32_t laneWidth{32};
+  alignas(64) char rows[TRANSPOSE_CHUNK_ROWS * laneWidth];
+
+  for (int32_t group{0}; group < nLines; group += laneWidth) {
+    const int32_t nLanes{std::min(laneWidth, nLines - group)};
+    const int64_t length{longestLine(lines + group, nLanes)};
+
+    const __m256i zero{_mm256_setzero_si256()};
+    __m256i first{zero};
+    __m256i last{zero};
+    for (int64_t column{0}; column < length; column++) {
+      const int64_t row{column % TRANSPOSE_CHUNK_COLUMNS};
+      if (row == 0) {
+        transposeChunk(lines + group, nLanes, laneWidth, column, rows);
+      }
+
+      __m256i letters[SPELLED_DIGIT_PADDING + 1];
+      for (int64_t k{0}; k <= SPELLED_DIGIT_PADDING; k++) {
+        letters[k] = _mm256_load_si256(
+            reinterpret_cast<const __m256i *>(rows + (row + k) * laneWidth));
+      }
+
+      const __m256i shifted{
+          _mm256_sub_epi8(letters[0], _mm256_set1_epi8('0'))};
+      const __m256i isDigit{_mm256_cmpeq_epi8(
+          _mm256_min_epu8(shifted, _mm256_set1_epi8(9)), shifted)};
+      __m256i found{_mm256_and_si256(
+          isDigit, _mm256_add_epi8(shifted, _mm256_set1_epi8(1)))};
+
+      for (int32_t word{0}; word < 9; word++) {
+        const std::string_view spelled{SPELLED_DIGITS[word]};
+        __m256i match{
+            _mm256_cmpeq_epi8(letters[0], _mm256_set1_epi8(spelled[0]))};
+        for (size_t k{1}; k < spelled.size(); k++) {
+          match = _mm256_and_si256(
+              match,
+              _mm256_cmpeq_epi8(letters[k], _mm256_set1_epi8(spelled[k])));
+        }
+        found = _mm256_or_si256(
+            found, _mm256_and_si256(match, _mm256_set1_epi8(word + 2)));
+      }
+
+      const __m256i none{_mm256_cmpeq_epi8(found, zero)};
+      first =
+          _mm256_blendv_epi8(first, found, _mm256_cmpeq_epi8(first, zero));
+      last = _mm256_blendv_epi8(found, last, none);
+    }
+
+    alignas(32) int8_t firstLanes[laneWidth];
+    alignas(32) int8_t lastLanes[laneWidth];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(firstLanes), first);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lastLanes), last);
+    for (int32_t lane{0}; lane < nLanes; lane++) {
+      retFirst[group + lane] = firstLanes[lane] - 1;
+      retLast[group + lane] = lastLanes[lane] - 1;
+    }
+  }
+}
+
+__attribute__((target("avx2"))) DigitBounds
+findDigitBoundsAvx2(const char *data, int64_t size) {
+  DigitBounds retBounds{-1, -1};
+
+  int64_t offset{0};
+  for (; offset + 32 <= size; offset += 32) {
+    const uint32_t mask{digitMask32(data + offset)};
+    if (mask != 0) {
+      retBounds.first = offset + std::countr_zero(mask);
+      break;
+    }
+  }
+  if (retBounds.first < 0) {
+    // No digit in the full blocks, so there is none before the tail either
+    const DigitBounds tail{
+        findDigitBoundsScalar(data + offset, size - offset)};
+    if (tail.first < 0) {
+      return retBounds;
+    }
+    retBounds.first = offset + tail.first;
+  }
+
+  int64_t end{size};
+  for (; end >= 32; end -= 32) {
+    const uint32_t mask{digitMask32(data + end - 32)};
+    if (mask != 0) {
+      retBounds.last = end - 1 - std::countl_zero(mask);
+      return retBounds;
+    }
+  }
+  retBounds.last = findDigitBoundsScalar(data, end).last;
+
+  return retBounds;
+}
+
+__attribute__((target("avx2"))) uint64_t digitMaskAvx2(const char *data,
+                                                        int64_t size) {
+  if (size < 64) {
+    // Zeroes are not digits
+    char buffer[64]{};
+    std::memcpy(buffer, data, size);
+    return digitMask32(buffer) |
+           (static_cast<uint64_t>(digitMask32(buffer + 32)) << 32);
+  }
+
+  return digitMask32(data) |
+         (static_cast<uint64_t>(digitMask32(data + 32)) << 32);
+}
+
+int64_t decodeNumbersAvx2(const char *data, int64_t size, int32_t *retNumbers,
+                          int64_t capacity) {
+  return decodeNumbersWith(digitMaskAvx2, data, size, retNumbers, capacity);
+}
+
+__attribute__((target("avx2"))) int64_t
+findContainingRangeAvx2(const int64_t *starts, const int64_t *ends, int64_t n,
+                        int64_t value) {
+  const __m256i values{_mm256_set1_epi64x(value)};
+
+  int64_t i{0};
+  for (; i + 4 <= n; i += 4) {
+    const __m256i start{
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(starts + i))};
+    const __m256i end{
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ends + i))};
+
+    const __m256i contains{_mm256_andnot_si256(
+        _mm256_cmpgt_epi64(start, values), _mm256_cmpgt_epi64(end, values))};
+    const int mask{_mm256_movemask_pd(_mm256_castsi256_pd(contains))};
+    if (mask != 0) {
+      return i + std::countr_zero(static_cast<unsigned>(mask));
+    }
+  }
+
+  return i + findContainingRangeScalar(starts + i, ends + i, n - i, value);
+}
+
+__attribute__((target("avx2"))) __m256i load256(const void *data) {
+  return _mm256_loadu_si256(static_cast<const __m256i *>(data));
+}
+
+__attribute__((target("avx2"))) MaskedSums
+sumWithinLimitsAvx2(const int32_t *x, const int32_t *y, const int32_t *z,
+                    const int64_t *first, const int64_t *second, int64_t n,
+                    int32_t xLimit, int32_t yLimit, int32_t zLimit) {
+  const __m256i xLimits{_mm256_set1_epi32(xLimit)};
+  const __m256i yLimits{_mm256_set1_epi32(yLimit)};
+  const __m256i zLimits{_mm256_set1_epi32(zLimit)};
+  __m256i firstSums{_mm256_setzero_si256()};
+  __m256i secondSums{_mm256_setzero_si256()};
+
+  int64_t i{0};
+  for (; i + 8 <= n; i += 8) {
+    const __m256i above{_mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpgt_epi32(load256(x + i), xLimits),
+                        _mm256_cmpgt_epi32(load256(y + i), yLimits)),
+        _mm256_cmpgt_epi32(load256(z + i), zLimits))};
+
+    const __m256i aboveLow{
+        _mm256_cvtepi32_epi64(_mm256_castsi256_si128(above))};
+    const __m256i aboveHigh{
+        _mm256_cvtepi32_epi64(_mm256_extracti128_si256(above, 1))};
+
+    firstSums = _mm256_add_epi64(
+        firstSums,
+        _mm256_add_epi64(_mm256_andnot_si256(aboveLow, load256(first + i)),
+                         _mm256_andnot_si256(aboveHigh,
+                                             load256(first + i + 4))));
+    secondSums = _mm256_add_epi64(
+        secondSums,
+        _mm256_add_epi64(_mm256_andnot_si256(aboveLow, load256(second + i)),
+                         _mm256_andnot_si256(aboveHigh,
+                                             load256(second + i + 4))));
+  }
+
+  alignas(32) int64_t firstLanes[4];
+  alignas(32) int64_t secondLanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(firstLanes), firstSums);
+  _mm256_store_si256(reinterpret_cast<__m256i *>(secondLanes), secondSums);
+
+  MaskedSums retSums{sumWithinLimitsScalar(x + i, y + i, z + i, first + i,
+                                           second + i, n - i, xLimit, yLimit,
+                                           zLimit)};
+  for (int32_t lane{0}; lane < 4; lane++) {
+    retSums.first += firstLanes[lane];
+    retSums.second += secondLanes[lane];
+  }
+  return retSums;
+}
+
+/* AVX-512 */
+
+__attribute__((target("avx512f,avx512bw"))) uint64_t
+digitMaskAvx512(const char *data, int64_t size) {
+  // Masked out bytes are neither loaded nor reported
+  const __mmask64 load{size >= 64 ? ~uint64_t{0}
+                                  : (uint64_t{1} << size) - 1};
+  const __m512i chunk{_mm512_maskz_loadu_epi8(load, data)};
+  const __m512i shifted{_mm512_sub_epi8(chunk, _mm512_set1_epi8('0'))};
+
+  return _mm512_mask_cmplt_epu8_mask(load, shifted, _mm512_set1_epi8(10));
+}
+
+__attribute__((target("avx512f,avx512bw"))) void
+findSpelledDigitsAvx512(const std::string_view *lines, int32_t nLines,
+                        int8_t *retFirst, int8_t *retLast) {
+  /**
+   * 64 lines at a time, the same way as `findSpelledDigitsSse42`, with the
+   * comparisons kept as masks.
+   **/
+  constexpr int32_t laneWidth{64};
+  alignas(64) char rows[TRANSPOSE_CHUNK_ROWS * laneWidth];
+
+  for (int32_t group{0}; group < nLines; group += laneWidth) {
+    const int32_t nLanes{std::min(laneWidth, nLines - group)};
+    const int64_t length{longestLine(lines + group, nLanes)};
+
+    __m512i first{_mm512_setzero_si512()};
+    __m512i last{_mm512_setzero_si512()};
+    for (int64_t column{0}; column < length; column++) {
+      const int64_t row{column % TRANSPOSE_CHUNK_COLUMNS};
+      if (row == 0) {
+        transposeChunk(lines + group, nLanes, laneWidth, column, rows);
+      }
+
+      __m512i letters[SPELLED_DIGIT_PADDING + 1];
+      for (int64_t k{0}; k <= SPELLED_DIGIT_PADDING; k++) {
+        letters[k] = _mm512_load_si512(rows + (row + k) * laneWidth);
+      }
+
+      const __m512i shifted{
+          _mm512_sub_epi8(letters[0], _mm512_set1_epi8('0'))};
+      __m512i found{_mm512_maskz_add_epi8(
+          _mm512_cmplt_epu8_mask(shifted, _mm512_set1_epi8(10)), shifted,
+          _mm512_set1_epi8(1))};
+
+      for (int32_t word{0}; word < 9; word++) {
+        const std::string_view spelled{SPELLED_DIGITS[word]};
+        __mmask64 match{
+            _mm512_cmpeq_epi8_mask(letters[0], _mm512_set1_epi8(spelled[0]))};
+        for (size_t k{1}; k < spelled.size(); k++) {
+          match = _mm512_mask_cmpeq_epi8_mask(match, letters[k],
+                                              _mm512_set1_epi8(spelled[k]));
+        }
+        found = _mm512_mask_mov_epi8(found, match, _mm512_set1_epi8(word + 2));
+      }
+
+      const __mmask64 any{_mm512_test_epi8_mask(found, found)};
+      first = _mm512_mask_mov_epi8(
+          first, any & ~_mm512_test_epi8_mask(first, first), found);
+      last = _mm512_mask_mov_epi8(last, any, found);
+    }
+
+    alignas(64) int8_t firstLanes[laneWidth];
+    alignas(64) int8_t lastLanes[laneWidth];
+    _mm512_store_si512(firstLanes, first);
+    _mm512_store_si512(lastLanes, last);
+    for (int32_t lane{0}; lane < nLanes; lane++) {
+      retFirst[group + lane] = firstLanes[lane] - 1;
+      retLast[group + lane] = lastLanes[lane] - 1;
+    }
+  }
+}
+
+__attribute__((target("avx512f,avx512bw"))) DigitBounds
+findDigitBoundsAvx512(const char *data, int64_t size) {
+  DigitBounds retBounds{-1, -1};
+
+  for (int64_t offset{0}; offset < size; offset += 64) {
+    const uint64_t mask{
+        digitMaskAvx512(data + offset, std::min<int64_t>(64, size - offset))};
+    if (mask != 0) {
+      retBounds.first = offset + std::countr_zero(mask);
+      break;
+    }
+  }
+  if (retBounds.first < 0) {
+    return retBounds;
+  }
+
+  for (int64_t end{size}; end > 0; end -= 64) {
+    const int64_t begin{std::max<int64_t>(0, end - 64)};
+    const uint64_t mask{digitMaskAvx512(data + begin, end - begin)};
+    if (mask != 0) {
+      retBounds.last = begin + 63 - std::countl_zero(mask);
+      break;
+    }
+  }
+
+  return retBounds;
+}
+
+int64_t decodeNumbersAvx512(const char *data, int64_t size,
+                            int32_t *retNumbers, int64_t capacity) {
+  return decodeNumbersWith(digitMaskAvx512, data, size, retNumbers, capacity);
+}
+
+__attribute__((target("avx512f"))) int64_t
+findContainingRangeAvx512(const int64_t *starts, const int64_t *ends,
+                          int64_t n, int64_t value) {
+  const __m512i values{_mm512_set1_epi64(value)};
+
+  for (int64_t i{0}; i < n; i += 8) {
+    const __mmask8 load{static_cast<__mmask8>(
+        n - i >= 8 ? 0xff : (1u << (n - i)) - 1)};
+    const __m512i start{_mm512_maskz_loadu_epi64(load, starts + i)};
+    const __m512i end{_mm512_maskz_loadu_epi64(load, ends + i)};
+
+    const __mmask8 contains{static_cast<__mmask8>(
+        load & _mm512_cmple_epi64_mask(start, values) &
+        _mm512_cmpgt_epi64_mask(end, values))};
+    if (contains != 0) {
+      return i + std::countr_zero(static_cast<unsigned>(contains));
+    }
+  }
+
+  return n;
+}
+
+__attribute__((target("avx512f"))) MaskedSums
+sumWithinLimitsAvx512(const int32_t *x, const int32_t *y, const int32_t *z,
+                      const int64_t *first, const int64_t *second, int64_t n,
+                      int32_t xLimit, int32_t yLimit, int32_t zLimit) {
+  const __m512i xLimits{_mm512_set1_epi32(xLimit)};
+  const __m512i yLimits{_mm512_set1_epi32(yLimit)};
+  const __m512i zLimits{_mm512_set1_epi32(zLimit)};
+  __m512i firstSums{_mm512_setzero_si512()};
+  __m512i secondSums{_mm512_setzero_si512()};
+
+  for (int64_t i{0}; i < n; i += 16) {
+    const __mmask16 load{static_cast<__mmask16>(
+        n - i >= 16 ? 0xffff : (1u << (n - i)) - 1)};
+
+    const __m512i xs{_mm512_maskz_loadu_epi32(load, x + i)};
+    const __m512i ys{_mm512_maskz_loadu_epi32(load, y + i)};
+    const __m512i zs{_mm512_maskz_loadu_epi32(load, z + i)};
+    const __mmask16 within{static_cast<__mmask16>(
+        _mm512_mask_cmple_epi32_mask(load, xs, xLimits) &
+        _mm512_mask_cmple_epi32_mask(load, ys, yLimits) &
+        _mm512_mask_cmple_epi32_mask(load, zs, zLimits))};
+
+    // Lanes outside `within` are neither loaded nor added
+    const __mmask8 low{static_cast<__mmask8>(within)};
+    const __mmask8 high{static_cast<__mmask8>(within >> 8)};
+    firstSums = _mm512_add_epi64(
+        _mm512_add_epi64(firstSums, _mm512_maskz_loadu_epi64(low, first + i)),
+        _mm512_maskz_loadu_epi64(high, first + i + 8));
+    secondSums = _mm512_add_epi64(
+        _mm512_add_epi64(secondSums,
+                         _mm512_maskz_loadu_epi64(low, second + i)),
+        _mm512_maskz_loadu_epi64(high, second + i + 8));
+  }
+
+  // `_mm512_reduce_add_epi64` trips GCC's -Wuninitialized
+  alignas(64) int64_t firstLanes[8];
+  alignas(64) int64_t secondLanes[8];
+  _mm512_store_si512(firstLanes, firstSums);
+  _mm512_store_si512(secondLanes, secondSums);
+
+  MaskedSums retSums{0, 0};
+  for (int32_t lane{0}; lane < 8; lane++) {
+    retSums.first += firstLanes[lane];
+    retSums.second += secondLanes[lane];
+  }
+  return retSums;
+}
+
+#else
+
+// Only the baseline kernels exist off x86-64
+#define findDigitBoundsSse42 findDigitBoundsScalar
+#define findDigitBoundsAvx2 findDigitBoundsScalar
+#define findDigitBoundsAvx512 findDigitBoundsScalar
+#define findSpelledDigitsSse42 findSpelledDigitsScalar
+#define findSpelledDigitsAvx2 findSpelledDigitsScalar
+#define findSpelledDigitsAvx512 findSpelledDigitsScalar
+#define decodeNumbersSse42 decodeNumbersScalar
+#define decodeNumbersAvx2 decodeNumbersScalar
+#define decodeNumbersAvx512 decodeNumbersScalar
+#define findContainingRangeSse42 findContainingRangeScalar
+#define findContainingRangeAvx2 findContainingRangeScalar
+#define findContainingRangeAvx512 findContainingRangeScalar
+#define sumWithinLimitsSse42 sumWithinLimitsScalar
+#define sumWithinLimitsAvx2 sumWithinLimitsScalar
+#define sumWithinLimitsAvx512 sumWithinLimitsScalar
+
+#endif
+
+} // namespace
+
+CpuLevel cpuLevel() {
+  static const CpuLevel level{[]() {
+    CpuLevel retLevel{detectCpuLevel()};
+
+    const char *levelEnv{std::getenv("ADVENT_CPU_LEVEL")};
+    if (levelEnv == nullptr) {
+      return retLevel;
+    }
+
+    const std::string cap{levelEnv};
+    if (cap == "baseline") {
+      retLevel = std::min(retLevel, CpuLevel::BASELINE);
+    } else if (cap == "sse42") {
+      retLevel = std::min(retLevel, CpuLevel::SSE42);
+    } else if (cap == "avx2") {
+      retLevel = std::min(retLevel, CpuLevel::AVX2);
+    } else if (cap != "avx512") {
+      std::cerr << "Ignoring unknown ADVENT_CPU_LEVEL: " << cap << std::endl;
+    }
+
+    return retLevel;
+  }()};
+
+  return level;
+}
+
+DigitBounds findDigitBounds(const char *data, int64_t size) {
+  static const auto kernel{
+      selectKernel(&findDigitBoundsScalar, &findDigitBoundsSse42,
+                   &findDigitBoundsAvx2, &findDigitBoundsAvx512)};
+  return kernel(data, size);
+}
+
+void findSpelledDigits(const std::string_view *lines, int32_t nLines,
+                       int8_t *retFirst, int8_t *retLast) {
+  static const auto kernel{
+      selectKernel(&findSpelledDigitsScalar, &findSpelledDigitsSse42,
+                   &findSpelledDigitsAvx2, &findSpelledDigitsAvx512)};
+  kernel(lines, nLines, retFirst, retLast);
+}
+
+int64_t decodeNumbers(const char *data, int64_t size, int32_t *retNumbers,
+                      int64_t capacity) {
+  static const auto kernel{
+      selectKernel(&decodeNumbersScalar, &decodeNumbersSse42,
+                   &decodeNumbersAvx2, &decodeNumbersAvx512)};
+  return kernel(data, size, retNumbers, capacity);
+}
+
+int64_t findContainingRange(const int64_t *starts, const int64_t *ends,
+                            int64_t n, int64_t value) {
+  static const auto kernel{
+      selectKernel(&findContainingRangeScalar, &findContainingRangeSse42,
+                   &findContainingRangeAvx2, &findContainingRangeAvx512)};
+  return kernel(starts, ends, n, value);
+}
+
+MaskedSums sumWithinLimits(const int32_t *x, const int32_t *y,
+                           const int32_t *z, const int64_t *first,
+                           const int64_t *second, int64_t n, int32_t xLimit,
+                           int32_t yLimit, int32_t zLimit) {
+  static const auto kernel{
+      selectKernel(&sumWithinLimitsScalar, &sumWithinLimitsSse42,
+                   &sumWithinLimitsAvx2, &sumWithinLimitsAvx512)};
+  return kernel(x, y, z, first, second, n, xLimit, yLimit, zLimit);
+}
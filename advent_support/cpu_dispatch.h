@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// Runtime CPU-feature dispatch for the vectorized kernels below. The CPU's
+// features are detected once with `cpuid`, and each kernel is bound to the
+// best implementation the CPU supports the first time it is called, so one
+// baseline x86-64 binary runs the AVX-512 kernels where they are available.
+//
+// `ADVENT_CPU_LEVEL=baseline|sse42|avx2|avx512` caps the level, e.g. to run
+// the fallbacks on a newer machine.
+
+enum class CpuLevel : int32_t { BASELINE, SSE42, AVX2, AVX512 };
+
+// The best level both the CPU and `ADVENT_CPU_LEVEL` allow
+CpuLevel cpuLevel();
+
+struct DigitBounds {
+  // The positions of the first and the last ASCII digit, -1 if there is none
+  int64_t first;
+  int64_t last;
+};
+
+DigitBounds findDigitBounds(const char *data, int64_t size);
+
+// The most lines `findSpelledDigits` takes at once
+constexpr int32_t SPELLED_DIGIT_BATCH{64};
+
+// The first and the last digit of each of the `nLines` lines, where "one" to
+// "nine" count as digits too, or -1 if a line has none. The lines are
+// transposed so that each one is a byte lane of the vectors, and every lane
+// advances one column at a time
+void findSpelledDigits(const std::string_view *lines, int32_t nLines,
+                       int8_t *retFirst, int8_t *retLast);
+
+// Decode the unsigned decimal numbers in [data, data + size), separated by
+// anything that is not a digit. Writes at most `capacity` of them to
+// `retNumbers`, and returns how many there are in total
+int64_t decodeNumbers(const char *data, int64_t size, int32_t *retNumbers,
+                      int64_t capacity);
+
+// The first `i` with `starts[i] <= value < ends[i]`, or `n` if there is none
+int64_t findContainingRange(const int64_t *starts, const int64_t *ends,
+                            int64_t n, int64_t value);
+
+struct MaskedSums {
+  int64_t first;
+  int64_t second;
+};
+
+// The sums of `first[i]` and of `second[i]` over the `i < n` with
+// `x[i] <= xLimit`, `y[i] <= yLimit` and `z[i] <= zLimit`
+MaskedSums sumWithinLimits(const int32_t *x, const int32_t *y,
+                           const int32_t *z, const int64_t *first,
+                           const int64_t *second, int64_t n, int32_t xLimit,
+                           int32_t yLimit, int32_t zLimit);
@@ -0,0 +1,405 @@
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <dlfcn.h>
+#include <zlib.h>
+
+#include "decompress.h"
+#include "profiling.h"
+
+namespace {
+
+class ChunkRing {
+  /**
+   * A fixed ring of buffers between one producer, which fills them, and one
+   * consumer, which drains them in the same order.
+   **/
+public:
+  struct Cancelled {};
+
+  ChunkRing() {
+    for (auto &buffer : mBuffers) {
+      buffer.reset(new char[DECOMPRESSED_CHUNK_SIZE]);
+    }
+  }
+
+  // Producer: the next empty buffer, once the consumer released it. Throws
+  // `Cancelled` once the consumer gave up
+  char *acquireEmpty() {
+    std::unique_lock<std::mutex> lock{mMutex};
+    mChanged.wait(lock, [this]() {
+      return mCancelled || mNFull < DECOMPRESSION_RING_SIZE;
+    });
+    if (mCancelled) {
+      throw Cancelled{};
+    }
+
+    return mBuffers[(mFirstFull + mNFull) % DECOMPRESSION_RING_SIZE].get();
+  }
+
+  // Producer: hand the buffer from `acquireEmpty` over, holding `size` bytes
+  void publish(const int64_t size) {
+    {
+      std::lock_guard<std::mutex> lock{mMutex};
+      mSizes[(mFirstFull + mNFull) % DECOMPRESSION_RING_SIZE] = size;
+      mNFull++;
+    }
+    mChanged.notify_all();
+  }
+
+  // Producer: no more buffers follow. `error` is rethrown to the consumer
+  void finish(std::exception_ptr error) {
+    {
+      std::lock_guard<std::mutex> lock{mMutex};
+      mFinished = true;
+      mError = std::move(error);
+    }
+    mChanged.notify_all();
+  }
+
+  // Consumer: the next full buffer, or false once the producer finished
+  bool acquireFull(std::string_view &retChunk) {
+    std::unique_lock<std::mutex> lock{mMutex};
+    mChanged.wait(lock, [this]() { return mNFull > 0 || mFinished; });
+    if (mNFull == 0) {
+      if (mError) {
+        std::rethrow_exception(mError);
+      }
+      return false;
+    }
+
+    retChunk = {mBuffers[mFirstFull].get(),
+                static_cast<size_t>(mSizes[mFirstFull])};
+    return true;
+  }
+
+  // Consumer: done with the buffer from `acquireFull`
+  void release() {
+    {
+      std::lock_guard<std::mutex> lock{mMutex};
+      mFirstFull = (mFirstFull + 1) % DECOMPRESSION_RING_SIZE;
+      mNFull--;
+    }
+    mChanged.notify_all();
+  }
+
+  // Consumer: stop the producer at its next `acquireEmpty`
+  void cancel() {
+    {
+      std::lock_guard<std::mutex> lock{mMutex};
+      mCancelled = true;
+    }
+    mChanged.notify_all();
+  }
+
+private:
+  std::unique_ptr<char[]> mBuffers[DECOMPRESSION_RING_SIZE]{};
+  int64_t mSizes[DECOMPRESSION_RING_SIZE]{};
+  int32_t mFirstFull{0};
+  int32_t mNFull{0};
+  bool mFinished{false};
+  bool mCancelled{false};
+  std::exception_ptr mError{};
+
+  std::mutex mMutex{};
+  std::condition_variable mChanged{};
+};
+
+class Decompressor {
+public:
+  virtual ~Decompressor() = default;
+
+  // Decompress from the front of `input` into [output, output + capacity),
+  // dropping what was consumed from `input`. Returns the number of bytes
+  // written, which is less than `capacity` only once the decompressor needs
+  // more input
+  virtual int64_t decompress(std::string_view &input, char *output,
+                             int64_t capacity) = 0;
+
+  // Whether the input so far ended on a complete stream
+  virtual bool atStreamEnd() const = 0;
+};
+
+class GzipDecompressor : public Decompressor {
+public:
+  GzipDecompressor() {
+    // 15 + 16: the largest window, with a gzip header and trailer
+    if (inflateInit2(&mStream, 15 + 16) != Z_OK) {
+      throw std::runtime_error("Error initializing zlib");
+    }
+  }
+
+  ~GzipDecompressor() override { inflateEnd(&mStream); }
+
+  GzipDecompressor(const GzipDecompressor &) = delete;
+  GzipDecompressor &operator=(const GzipDecompressor &) = delete;
+
+  int64_t decompress(std::string_view &input, char *output,
+                     const int64_t capacity) override {
+    mStream.next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    mStream.avail_in = static_cast<uInt>(input.size());
+    mStream.next_out = reinterpret_cast<Bytef *>(output);
+    mStream.avail_out = static_cast<uInt>(capacity);
+
+    while (mStream.avail_out > 0) {
+      // `gzip` concatenates members, e.g. for `cat a.gz b.gz`. Zero bytes
+      // after the last one, as tape archives pad it with, are skipped like
+      // `gzip -d` does: a member never starts with one
+      if (mAtStreamEnd) {
+        while (mStream.avail_in > 0 && *mStream.next_in == 0) {
+          mStream.next_in++;
+          mStream.avail_in--;
+          mInPadding = true;
+        }
+        if (mStream.avail_in == 0) {
+          break;
+        }
+        if (mInPadding) {
+          throw std::runtime_error(
+              "Malformed gzip input: data after the trailing zeros");
+        }
+        inflateReset(&mStream);
+        mAtStreamEnd = false;
+      }
+
+      const int32_t result{inflate(&mStream, Z_NO_FLUSH)};
+      if (result == Z_STREAM_END) {
+        mAtStreamEnd = true;
+      } else if (result == Z_BUF_ERROR) {
+        // No progress without more input
+        break;
+      } else if (result != Z_OK) {
+        throw std::runtime_error(
+            std::string{"Malformed gzip input: "} +
+            (mStream.msg != nullptr ? mStream.msg : "unknown error"));
+      }
+    }
+
+    input.remove_prefix(input.size() - mStream.avail_in);
+    return capacity - mStream.avail_out;
+  }
+
+  bool atStreamEnd() const override { return mAtStreamEnd; }
+
+private:
+  z_stream mStream{};
+  bool mAtStreamEnd{false};
+  bool mInPadding{false};
+};
+
+class ZstdLibrary {
+  /**
+   * The streaming decompression API of `libzstd.so.1`, which is ABI stable.
+   **/
+public:
+  struct InBuffer {
+    const void *src;
+    size_t size;
+    size_t pos;
+  };
+
+  struct OutBuffer {
+    void *dst;
+    size_t size;
+    size_t pos;
+  };
+
+  static const ZstdLibrary &get() {
+    static const ZstdLibrary library;
+    return library;
+  }
+
+  void *(*createDStream)(){nullptr};
+  size_t (*freeDStream)(void *){nullptr};
+  size_t (*decompressStream)(void *, OutBuffer *, InBuffer *){nullptr};
+  unsigned (*isError)(size_t){nullptr};
+  const char *(*getErrorName)(size_t){nullptr};
+
+private:
+  ZstdLibrary() : mHandle{dlopen("libzstd.so.1", RTLD_NOW | RTLD_LOCAL)} {
+    if (mHandle == nullptr) {
+      throw std::runtime_error("Reading zstd input needs libzstd.so.1");
+    }
+
+    load(createDStream, "ZSTD_createDStream");
+    load(freeDStream, "ZSTD_freeDStream");
+    load(decompressStream, "ZSTD_decompressStream");
+    load(isError, "ZSTD_isError");
+    load(getErrorName, "ZSTD_getErrorName");
+  }
+
+  template <typename Function>
+  void load(Function &retFunction, const char *name) {
+    retFunction = reinterpret_cast<Function>(dlsym(mHandle, name));
+    if (retFunction == nullptr) {
+      throw std::runtime_error(std::string{"libzstd.so.1 lacks "} + name);
+    }
+  }
+
+  // Never closed, the functions are used for the rest of the process
+  void *mHandle;
+};
+
+class ZstdDecompressor : public Decompressor {
+public:
+  ZstdDecompressor()
+      : mLibrary{ZstdLibrary::get()}, mStream{mLibrary.createDStream()} {
+    if (mStream == nullptr) {
+      throw std::runtime_error("Error initializing zstd");
+    }
+  }
+
+  ~ZstdDecompressor() override { mLibrary.freeDStream(mStream); }
+
+  ZstdDecompressor(const ZstdDecompressor &) = delete;
+  ZstdDecompressor &operator=(const ZstdDecompressor &) = delete;
+
+  int64_t decompress(std::string_view &input, char *output,
+                     const int64_t capacity) override {
+    ZstdLibrary::InBuffer in{input.data(), input.size(), 0};
+    ZstdLibrary::OutBuffer out{output, static_cast<size_t>(capacity), 0};
+
+    // Concatenated frames are decoded one after the other
+    while (out.pos < out.size) {
+      const size_t inBefore{in.pos};
+      const size_t outBefore{out.pos};
+
+      const size_t result{mLibrary.decompressStream(mStream, &out, &in)};
+      if (mLibrary.isError(result) != 0) {
+        throw std::runtime_error(std::string{"Malformed zstd input: "} +
+                                 mLibrary.getErrorName(result));
+      }
+      if (in.pos == inBefore && out.pos == outBefore) {
+        break;
+      }
+
+      // 0 once a frame was decoded and flushed in full
+      mAtStreamEnd = result == 0;
+    }
+
+    input.remove_prefix(in.pos);
+    return static_cast<int64_t>(out.pos);
+  }
+
+  bool atStreamEnd() const override { return mAtStreamEnd; }
+
+private:
+  const ZstdLibrary &mLibrary;
+  void *mStream;
+  bool mAtStreamEnd{false};
+};
+
+std::unique_ptr<Decompressor> makeDecompressor(const Compression compression) {
+  if (compression == Compression::GZIP) {
+    return std::make_unique<GzipDecompressor>();
+  }
+  if (compression == Compression::ZSTD) {
+    return std::make_unique<ZstdDecompressor>();
+  }
+  throw std::invalid_argument("Not a compressed input");
+}
+
+void produceChunks(Compression compression,
+                   const std::function<void(const ChunkSink &)> &readCompressed,
+                   ChunkRing &ring) {
+  ADVENT_PROFILE_SCOPE("decompress");
+  const std::unique_ptr<Decompressor> decompressor{
+      makeDecompressor(compression)};
+
+  // The buffer being filled, from the ring
+  char *output{nullptr};
+  int64_t filled{0};
+
+  readCompressed([&](std::string_view input) {
+    while (true) {
+      if (output == nullptr) {
+        output = ring.acquireEmpty();
+        filled = 0;
+      }
+
+      filled += decompressor->decompress(input, output + filled,
+                                         DECOMPRESSED_CHUNK_SIZE - filled);
+      if (filled < DECOMPRESSED_CHUNK_SIZE) {
+        break;
+      }
+
+      ADVENT_PROFILE_COUNT("io.bytesDecompressed", filled);
+      ring.publish(filled);
+      output = nullptr;
+    }
+
+    if (!input.empty()) {
+      throw std::runtime_error("Malformed compressed input");
+    }
+  });
+
+  if (!decompressor->atStreamEnd()) {
+    throw std::runtime_error("Truncated compressed input");
+  }
+
+  if (output != nullptr && filled > 0) {
+    ADVENT_PROFILE_COUNT("io.bytesDecompressed", filled);
+    ring.publish(filled);
+  }
+}
+
+} // namespace
+
+Compression detectCompression(std::string_view head) {
+  if (head.substr(0, 2) == std::string_view{"\x1f\x8b", 2}) {
+    return Compression::GZIP;
+  }
+  if (head.substr(0, 4) == std::string_view{"\x28\xb5\x2f\xfd", 4}) {
+    return Compression::ZSTD;
+  }
+  return Compression::NONE;
+}
+
+void decompressChunks(
+    Compression compression,
+    const std::function<void(const ChunkSink &)> &readCompressed,
+    const ChunkSink &onChunk) {
+  /**
+   * The producer thread reads and decompresses up to
+   * `DECOMPRESSION_RING_SIZE` chunks ahead of the caller's `onChunk`.
+   **/
+  ChunkRing ring;
+  const ScopedTimer *const profileScope{ADVENT_PROFILE_CURRENT_SCOPE()};
+
+  std::thread producer{[&]() {
+    ADVENT_PROFILE_ADOPT_SCOPE(profileScope);
+    try {
+      produceChunks(compression, readCompressed, ring);
+      ring.finish(nullptr);
+    } catch (const ChunkRing::Cancelled &) {
+      ring.finish(nullptr);
+    } catch (...) {
+      ring.finish(std::current_exception());
+    }
+  }};
+
+  try {
+    std::string_view chunk;
+    while (ring.acquireFull(chunk)) {
+      onChunk(chunk);
+      ring.release();
+    }
+  } catch (...) {
+    ring.cancel();
+    producer.join();
+    throw;
+  }
+
+  producer.join();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+// Streaming decompression of gzip and zstd inputs. The compressed chunks are
+// decompressed on a separate thread into a ring of buffers, which the caller
+// consumes while the next ones are decompressed.
+//
+// gzip goes through zlib. zstd goes through `libzstd.so.1`, loaded the first
+// time a zstd input is read, so the build needs no zstd headers.
+
+constexpr int64_t DECOMPRESSED_CHUNK_SIZE{1 << 20};
+constexpr int32_t DECOMPRESSION_RING_SIZE{4};
+
+enum class Compression : int32_t { NONE, GZIP, ZSTD };
+
+// The most bytes `detectCompression` looks at
+constexpr int64_t COMPRESSION_MAGIC_SIZE{4};
+
+// The compression format of a file starting with `head`, from its magic bytes
+Compression detectCompression(std::string_view head);
+
+// Called with each compressed chunk, in order
+using ChunkSink = std::function<void(std::string_view)>;
+
+// Decompress what `readCompressed` hands to its sink on a separate thread,
+// and call `onChunk` with the decompressed chunks, in order. The chunk's
+// memory is reused once `onChunk` returns
+void decompressChunks(
+    Compression compression,
+    const std::function<void(const ChunkSink &)> &readCompressed,
+    const ChunkSink &onChunk);
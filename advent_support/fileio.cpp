@@ -1,45 +1,294 @@
-#include <fstream>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
 #include <vector>
 
-std::vector<std::string> readFileAsLines(const std::string &filename) {
-  std::ifstream file{filename};
+#include "async_reader.h"
+#include "fileio.h"
+#include "profiling.h"
+
+namespace {
+
+std::string loadFileAsString(const std::string &filename) {
+  std::string fileContents;
 
-  // Check if the file was opened correctly
-  if (!file.is_open()) {
-    throw std::runtime_error("Error opening file: " + filename);
+  // Appending chunk by chunk would otherwise keep reallocating
+  std::error_code error;
+  const uintmax_t fileSize{std::filesystem::file_size(filename, error)};
+  if (!error) {
+    fileContents.reserve(fileSize);
   }
 
-  std::vector<std::string> lines;
+  readFileChunks(filename, [&fileContents](std::string_view chunk) {
+    fileContents.append(chunk);
+  });
 
-  // Read each line from the string
-  std::string line;
-  while (std::getline(file, line)) {
-    lines.push_back(line);
+  // Move semantics makes this an OK thing to do
+  return fileContents;
+}
+
+using SharedContents = std::shared_ptr<const std::string>;
+
+std::atomic<bool> fileCacheEnabled{false};
+
+// What a cached file looked like when it was read. A pinned entry is not
+// backed by a file, and never goes stale
+struct FileStamp {
+  std::filesystem::file_time_type modified{};
+  uintmax_t size{0};
+  bool pinned{false};
+
+  bool operator==(const FileStamp &other) const {
+    return modified == other.modified && size == other.size &&
+           pinned == other.pinned;
+  }
+};
+
+FileStamp stampFile(const std::string &filename) {
+  // A file that cannot be stat'ed gets the empty stamp, the read itself
+  // reports the error
+  std::error_code error;
+  FileStamp stamp{};
+  stamp.modified = std::filesystem::last_write_time(filename, error);
+  stamp.size = error ? 0 : std::filesystem::file_size(filename, error);
+  return error ? FileStamp{} : stamp;
+}
+
+struct CacheEntry {
+  FileStamp stamp{};
+  std::shared_future<SharedContents> contents{};
+  // The bytes the entry counts against the budget, 0 while it loads and for
+  // pinned entries
+  int64_t size{0};
+  uint64_t lastUsed{0};
+  // Tells the loads of the same file apart
+  uint64_t loadId{0};
+};
+
+std::mutex cacheMutex;
+std::map<std::string, CacheEntry> cache;
+int64_t cacheBytes{0};
+int64_t cacheBudget{FILE_CACHE_BUDGET};
+uint64_t cacheClock{0};
+
+// All of these with `cacheMutex` held
+
+void eraseEntry(std::map<std::string, CacheEntry>::iterator it) {
+  cacheBytes -= it->second.size;
+  cache.erase(it);
+}
+
+void storeEntry(const std::string &filename, CacheEntry entry) {
+  auto it{cache.find(filename)};
+  if (it != cache.end()) {
+    eraseEntry(it);
+  }
+
+  entry.lastUsed = ++cacheClock;
+  entry.loadId = entry.lastUsed;
+  cacheBytes += entry.size;
+  cache.emplace(filename, std::move(entry));
+}
+
+void evictOverBudget(const std::string &keep) {
+  /**
+   * Drop the least recently used loaded files until the cache fits its
+   * budget again. `keep`, the file just loaded, stays even if it alone is
+   * over the budget, its reader is about to use it.
+   **/
+  while (cacheBytes > cacheBudget) {
+    auto victim{cache.end()};
+    for (auto it{cache.begin()}; it != cache.end(); it++) {
+      if (it->second.size > 0 && it->first != keep &&
+          (victim == cache.end() ||
+           it->second.lastUsed < victim->second.lastUsed)) {
+        victim = it;
+      }
+    }
+    if (victim == cache.end()) {
+      return;
+    }
+
+    ADVENT_PROFILE_COUNT("io.fileCacheEvictions", 1);
+    eraseEntry(victim);
+  }
+}
+
+SharedContents cachedFileContents(const std::string &filename) {
+  /**
+   * Load `filename` at most once per version of it. Concurrent readers of the
+   * same file wait on the first one's load instead of reading it again, and a
+   * file that changed since it was cached is read again, replacing the stale
+   * version.
+   **/
+  std::promise<SharedContents> loadPromise;
+  std::shared_future<SharedContents> contents;
+  bool isLoader{false};
+  uint64_t loadId{0};
+
+  {
+    std::lock_guard<std::mutex> lock{cacheMutex};
+    auto it{cache.find(filename)};
+
+    if (it != cache.end() && it->second.stamp.pinned) {
+      contents = it->second.contents;
+    } else {
+      const FileStamp stamp{stampFile(filename)};
+      if (it == cache.end() || !(it->second.stamp == stamp)) {
+        contents = loadPromise.get_future().share();
+        storeEntry(filename, CacheEntry{stamp, contents});
+        loadId = cacheClock;
+        isLoader = true;
+      } else {
+        contents = it->second.contents;
+        it->second.lastUsed = ++cacheClock;
+      }
+    }
+  }
+
+  if (isLoader) {
+    try {
+      const SharedContents loaded{
+          std::make_shared<const std::string>(loadFileAsString(filename))};
+
+      {
+        // Unless the entry was replaced or evicted in the meantime
+        std::lock_guard<std::mutex> lock{cacheMutex};
+        auto it{cache.find(filename)};
+        if (it != cache.end() && it->second.loadId == loadId) {
+          it->second.size = static_cast<int64_t>(loaded->size());
+          cacheBytes += it->second.size;
+          evictOverBudget(filename);
+        }
+      }
+      loadPromise.set_value(loaded);
+    } catch (...) {
+      // Do not cache failures, a later read may well succeed
+      {
+        std::lock_guard<std::mutex> lock{cacheMutex};
+        auto it{cache.find(filename)};
+        if (it != cache.end() && !it->second.stamp.pinned) {
+          eraseEntry(it);
+        }
+      }
+      loadPromise.set_exception(std::current_exception());
+    }
   }
 
-  // Clean up
-  file.close();
+  return contents.get();
+}
+
+} // namespace
+
+std::vector<std::string> readFileAsLines(const std::string &filename) {
+  ADVENT_PROFILE_SCOPE("readFileAsLines");
+
+  std::vector<std::string> lines;
+  forEachLine(filename,
+              [&lines](const std::string &line) { lines.push_back(line); });
 
   // Move semantics makes this an OK thing to do
   return lines;
 }
 
+void forEachChunk(const std::string &filename,
+                  const std::function<void(std::string_view)> &onChunk) {
+  if (!fileCacheEnabled.load()) {
+    readFileChunks(filename, onChunk);
+    return;
+  }
+
+  // Cached contents are handed out in read-sized slices all the same
+  const SharedContents contents{cachedFileContents(filename)};
+  const std::string_view whole{*contents};
+  for (size_t offset{0}; offset < whole.size();
+       offset += ASYNC_READ_CHUNK_SIZE) {
+    onChunk(whole.substr(offset, ASYNC_READ_CHUNK_SIZE));
+  }
+}
+
+void forEachLine(const std::string &filename,
+                 const std::function<void(const std::string &)> &onLine) {
+  /**
+   * Lines are split the same way `std::getline` would: a trailing newline
+   * does not produce an empty last line.
+   **/
+
+  // A line may straddle two chunks, `line` carries its start over
+  std::string line;
+  int64_t nLines{0};
+  auto splitChunk{[&](std::string_view chunk) {
+    size_t lineStart{0};
+    size_t lineEnd{chunk.find('\n')};
+
+    while (lineEnd != std::string_view::npos) {
+      line.append(chunk, lineStart, lineEnd - lineStart);
+      onLine(line);
+      line.clear();
+      nLines++;
+
+      lineStart = lineEnd + 1;
+      lineEnd = chunk.find('\n', lineStart);
+    }
+
+    line.append(chunk, lineStart);
+  }};
+
+  forEachChunk(filename, splitChunk);
+
+  if (!line.empty()) {
+    onLine(line);
+    nLines++;
+  }
+
+  ADVENT_PROFILE_COUNT("io.linesRead", nLines);
+}
+
 std::string readFileAsString(const std::string &filename) {
-  std::ifstream file{filename};
+  ADVENT_PROFILE_SCOPE("readFileAsString");
+
+  if (fileCacheEnabled.load()) {
+    return *cachedFileContents(filename);
+  }
 
-  // Check if the file was opened correctly
-  if (!file.is_open()) {
-    throw std::runtime_error("Error opening file: " + filename);
+  return loadFileAsString(filename);
+}
+
+void enableFileCache(const int64_t budgetBytes) {
+  {
+    std::lock_guard<std::mutex> lock{cacheMutex};
+    cacheBudget = budgetBytes;
+    evictOverBudget("");
   }
+  fileCacheEnabled.store(true);
+}
 
-  // Read the entire file into a string
-  std::string fileContents{std::istreambuf_iterator<char>(file),
-                           std::istreambuf_iterator<char>()};
+void pinFileContents(const std::string &filename, std::string contents) {
+  std::promise<SharedContents> contentsPromise;
+  contentsPromise.set_value(
+      std::make_shared<const std::string>(std::move(contents)));
 
-  // Clean up
-  file.close();
+  FileStamp stamp{};
+  stamp.pinned = true;
 
-  // Move semantics makes this an OK thing to do
-  return fileContents;
+  std::lock_guard<std::mutex> lock{cacheMutex};
+  storeEntry(filename,
+             CacheEntry{stamp, contentsPromise.get_future().share()});
+}
+
+void evictFile(const std::string &filename) {
+  std::lock_guard<std::mutex> lock{cacheMutex};
+  auto it{cache.find(filename)};
+  if (it != cache.end()) {
+    eraseEntry(it);
+  }
 }
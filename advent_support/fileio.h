@@ -1,8 +1,39 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 std::vector<std::string> readFileAsLines(const std::string &filename);
 
+// Call `onChunk` with consecutive pieces of `filename`, through the file cache
+// if it is enabled. The chunk's memory may be reused once `onChunk` returns
+void forEachChunk(const std::string &filename,
+                  const std::function<void(std::string_view)> &onChunk);
+
+// Call `onLine` with each line of `filename` as soon as the read holding it
+// completed, while the rest of the file is still being read. The line's
+// memory is reused once `onLine` returns
+void forEachLine(const std::string &filename,
+                 const std::function<void(const std::string &)> &onLine);
+
 std::string readFileAsString(const std::string &filename);
+
+// The default memory budget of the file cache
+constexpr int64_t FILE_CACHE_BUDGET{int64_t{512} << 20};
+
+// Keep the contents of the files read in memory, so that repeated reads of
+// the same file skip the I/O. A file whose size or modification time changed
+// since is read again, and the least recently used files are dropped once
+// the cache holds more than `budgetBytes`. Pinned contents do not count
+// against the budget
+void enableFileCache(int64_t budgetBytes = FILE_CACHE_BUDGET);
+
+// Serve `contents` for reads of `filename` while the file cache is enabled,
+// whether or not there is such a file, until `evictFile(filename)`
+void pinFileContents(const std::string &filename, std::string contents);
+
+// Drop `filename` from the file cache
+void evictFile(const std::string &filename);
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "incremental.h"
+#include "profiling.h"
+
+namespace {
+
+const std::string CACHE_VERSION{"advent-block-cache-v1"};
+
+uint64_t hashLines(const std::vector<std::string> &lines, int64_t begin,
+                   int64_t end) {
+  // FNV-1a over the lines, each terminated by a newline
+  uint64_t hash{0xcbf29ce484222325};
+  auto mix{[&hash](unsigned char c) {
+    hash ^= c;
+    hash *= 0x100000001b3;
+  }};
+
+  for (int64_t i{begin}; i < end; i++) {
+    for (const char c : lines[i]) {
+      mix(static_cast<unsigned char>(c));
+    }
+    mix('\n');
+  }
+
+  return hash;
+}
+
+} // namespace
+
+BlockCache::BlockCache(const std::string &inputFilename,
+                       const std::string &tag, int64_t valuesPerBlock,
+                       int64_t valuesPerLine)
+    : mCacheFilename{inputFilename + ".cache"}, mTag{tag},
+      mValuesPerBlock{valuesPerBlock}, mValuesPerLine{valuesPerLine} {
+  std::ifstream file{mCacheFilename};
+
+  // No cache yet, everything will be solved from scratch
+  if (!file.is_open()) {
+    return;
+  }
+
+  std::string version;
+  std::string cachedTag;
+  int64_t blockSize{};
+  if (!(file >> version >> cachedTag >> blockSize) ||
+      version != CACHE_VERSION || cachedTag != mTag ||
+      blockSize != BLOCK_SIZE) {
+    return;
+  }
+
+  // Each line is `<hash> <nValues> <values>...`. Every block but the last
+  // is full, and a count that fits no block means the cache is corrupt, so
+  // everything is solved from scratch
+  Block block{};
+  int64_t nBlockValues{};
+  while (file >> block.hash >> nBlockValues) {
+    const bool lastBlockFull{mBlocks.empty() ||
+                             mBlocks.back().values.size() ==
+                                 static_cast<size_t>(nValues(BLOCK_SIZE))};
+    const int64_t nBlockLines{
+        mValuesPerLine == 0 ? 1 : (nBlockValues - mValuesPerBlock) /
+                                      mValuesPerLine};
+    if (!lastBlockFull || nBlockLines < 1 || nBlockLines > BLOCK_SIZE ||
+        nBlockValues != nValues(nBlockLines)) {
+      mBlocks.clear();
+      return;
+    }
+
+    block.values.resize(nBlockValues);
+    for (int64_t &value : block.values) {
+      file >> value;
+    }
+
+    if (!file) {
+      // A truncated cache is only good up to the last complete block
+      break;
+    }
+    mBlocks.push_back(block);
+  }
+}
+
+int64_t BlockCache::refresh(const std::vector<std::string> &lines,
+                            const BlockSolver &solveBlock) {
+  const int64_t nLines{static_cast<int64_t>(lines.size())};
+  const int64_t nBlocksNow{(nLines + BLOCK_SIZE - 1) / BLOCK_SIZE};
+
+  // Blocks past the end of a shrunk input are gone
+  if (nBlocks() > nBlocksNow) {
+    mBlocks.resize(nBlocksNow);
+  }
+
+  int64_t firstChanged{nBlocksNow};
+  for (int64_t block{0}; block < nBlocksNow; block++) {
+    const int64_t begin{block * BLOCK_SIZE};
+    const int64_t end{std::min(begin + BLOCK_SIZE, nLines)};
+    const uint64_t hash{hashLines(lines, begin, end)};
+
+    if (block < nBlocks() && mBlocks[block].hash == hash &&
+        mBlocks[block].values.size() ==
+            static_cast<size_t>(nValues(end - begin))) {
+      ADVENT_PROFILE_COUNT("incremental.blocksReused", 1);
+      continue;
+    }
+
+    ADVENT_PROFILE_SCOPE("parse");
+    Block solved{hash, solveBlock(begin, end)};
+    if (block < nBlocks()) {
+      mBlocks[block] = std::move(solved);
+    } else {
+      mBlocks.push_back(std::move(solved));
+    }
+
+    firstChanged = std::min(firstChanged, block);
+    mNRecomputed++;
+    ADVENT_PROFILE_COUNT("incremental.blocksSolved", 1);
+  }
+
+  return firstChanged;
+}
+
+bool BlockCache::save() const {
+  /**
+   * Write to a uniquely named temporary file next to the cache first, so
+   * that an interrupted save never leaves a corrupt cache behind, and two
+   * runs saving at once never write the same temporary file. The cache is
+   * only an optimization: when its directory is not writable it is skipped.
+   **/
+  std::ostringstream contents;
+  contents << CACHE_VERSION << " " << mTag << " " << BLOCK_SIZE << "\n";
+  for (const Block &block : mBlocks) {
+    contents << block.hash << " " << block.values.size();
+    for (const int64_t value : block.values) {
+      contents << " " << value;
+    }
+    contents << "\n";
+  }
+
+  std::string temporaryFilename{mCacheFilename + ".XXXXXX"};
+  const int32_t fd{mkstemp(temporaryFilename.data())};
+  if (fd < 0) {
+    return false;
+  }
+
+  const std::string data{std::move(contents).str()};
+  bool written{true};
+  for (size_t offset{0}; written && offset < data.size();) {
+    const ssize_t nWritten{
+        write(fd, data.data() + offset, data.size() - offset)};
+    if (nWritten < 0 && errno == EINTR) {
+      continue;
+    }
+    written = nWritten > 0;
+    offset += written ? static_cast<size_t>(nWritten) : 0;
+  }
+
+  written = close(fd) == 0 && written &&
+            std::rename(temporaryFilename.c_str(), mCacheFilename.c_str()) == 0;
+  if (!written) {
+    unlink(temporaryFilename.c_str());
+  }
+  return written;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class BlockCache {
+  /**
+   * Persisted partial results for the per-line solvers. The input is split
+   * into blocks of `BLOCK_SIZE` lines, and each block's hash is stored along
+   * with the values its solver produced for it. On a rerun only the blocks
+   * whose hash changed, or which were appended, are solved again.
+   *
+   * The cache lives next to the input, in `<input>.cache`, and is skipped
+   * when that directory is not writable.
+   **/
+public:
+  static constexpr int64_t BLOCK_SIZE{1024};
+
+  // Solves lines [begin, end), returning that block's partial results
+  using BlockSolver = std::function<std::vector<int64_t>(int64_t, int64_t)>;
+
+  // `tag` identifies the solver, a cache written by another one is ignored.
+  // A block of n lines has `valuesPerBlock + n * valuesPerLine` values, and a
+  // cache holding any other count is ignored as well
+  BlockCache(const std::string &inputFilename, const std::string &tag,
+             int64_t valuesPerBlock, int64_t valuesPerLine = 0);
+
+  // Bring every block up to date with `lines`. Returns the index of the
+  // first block that had to be solved again, or `nBlocks()` if none did
+  int64_t refresh(const std::vector<std::string> &lines,
+                  const BlockSolver &solveBlock);
+
+  int64_t nBlocks() const { return static_cast<int64_t>(mBlocks.size()); }
+
+  int64_t nRecomputed() const { return mNRecomputed; }
+
+  const std::vector<int64_t> &values(int64_t block) const {
+    return mBlocks[block].values;
+  }
+
+  // Overwrite the values of an up-to-date `block`
+  void setValues(int64_t block, std::vector<int64_t> values) {
+    mBlocks[block].values = std::move(values);
+  }
+
+  // Returns false, leaving any previous cache in place, if the cache could
+  // not be written
+  bool save() const;
+
+private:
+  int64_t nValues(int64_t nLines) const {
+    return mValuesPerBlock + nLines * mValuesPerLine;
+  }
+
+  struct Block {
+    uint64_t hash{0};
+    std::vector<int64_t> values{};
+  };
+
+  std::string mCacheFilename;
+  std::string mTag;
+  int64_t mValuesPerBlock;
+  int64_t mValuesPerLine;
+  std::vector<Block> mBlocks{};
+  int64_t mNRecomputed{0};
+};
@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "input_generators.h"
+
+namespace {
+
+class Rng {
+  /**
+   * Thin wrapper around `std::mt19937_64`. The engine's output sequence is
+   * fixed by the standard, but the `std::*_distribution`s are not, so the
+   * range reductions are done by hand to keep the generated inputs identical
+   * across standard libraries.
+   **/
+public:
+  explicit Rng(uint64_t seed) : mEngine{seed} {}
+
+  // Uniform integer in [lo, hi]
+  int64_t uniform(int64_t lo, int64_t hi) {
+    const uint64_t span{static_cast<uint64_t>(hi - lo) + 1};
+    return lo + static_cast<int64_t>(mEngine() % span);
+  }
+
+  // Uniform real in [0, 1)
+  double real() { return static_cast<double>(mEngine() >> 11) * 0x1.0p-53; }
+
+  bool chance(double probability) { return real() < probability; }
+
+  template <typename T> void shuffle(std::vector<T> &values) {
+    // Fisher-Yates
+    for (int64_t i{static_cast<int64_t>(values.size()) - 1}; i > 0; i--) {
+      std::swap(values[i], values[uniform(0, i)]);
+    }
+  }
+
+private:
+  std::mt19937_64 mEngine;
+};
+
+constexpr std::array<std::string_view, 9> DIGIT_WORDS{
+    "one", "two", "three", "four", "five", "six", "seven", "eight", "nine",
+};
+
+constexpr std::array<std::string_view, 3> MARBLE_COLORS{"red", "green",
+                                                        "blue"};
+
+constexpr std::string_view SYMBOLS{"*#+$/@=%&-"};
+
+constexpr std::array<std::string_view, 8> ALMANAC_CATEGORIES{
+    "seed",  "soil",        "fertilizer", "water",
+    "light", "temperature", "humidity",   "location",
+};
+
+} // namespace
+
+std::string generateDay1Input(int64_t nLines, uint64_t seed) {
+  Rng rng{seed};
+  std::string retInput;
+  retInput.reserve(nLines * 24);
+
+  for (int64_t i{0}; i < nLines; i++) {
+    const int64_t nTokens{rng.uniform(2, 10)};
+
+    // Every line must contain at least one plain digit, otherwise part A
+    // has no calibration value for it
+    const int64_t digitToken{rng.uniform(0, nTokens - 1)};
+
+    for (int64_t t{0}; t < nTokens; t++) {
+      const int64_t kind{t == digitToken ? 0 : rng.uniform(0, 2)};
+
+      if (kind == 0) {
+        retInput.push_back(static_cast<char>('1' + rng.uniform(0, 8)));
+      } else if (kind == 1) {
+        retInput.append(DIGIT_WORDS[rng.uniform(0, 8)]);
+      } else {
+        const int64_t nLetters{rng.uniform(1, 4)};
+        for (int64_t l{0}; l < nLetters; l++) {
+          retInput.push_back(static_cast<char>('a' + rng.uniform(0, 25)));
+        }
+      }
+    }
+
+    retInput.push_back('\n');
+  }
+
+  return retInput;
+}
+
+std::string generateDay2Input(int64_t nGames, uint64_t seed) {
+  Rng rng{seed};
+  std::string retInput;
+  retInput.reserve(nGames * 96);
+
+  for (int64_t gameId{1}; gameId <= nGames; gameId++) {
+    retInput.append("Game " + std::to_string(gameId) + ":");
+
+    const int64_t nDraws{rng.uniform(1, 6)};
+    for (int64_t d{0}; d < nDraws; d++) {
+      // Pick a non-empty subset of the colors in a random order
+      std::vector<int32_t> colors{0, 1, 2};
+      rng.shuffle(colors);
+      colors.resize(rng.uniform(1, 3));
+
+      for (size_t c{0}; c < colors.size(); c++) {
+        retInput.push_back(' ');
+        retInput.append(std::to_string(rng.uniform(1, 20)));
+        retInput.push_back(' ');
+        retInput.append(MARBLE_COLORS[colors[c]]);
+        if (c + 1 < colors.size()) {
+          retInput.push_back(',');
+        }
+      }
+
+      if (d + 1 < nDraws) {
+        retInput.push_back(';');
+      }
+    }
+
+    retInput.push_back('\n');
+  }
+
+  return retInput;
+}
+
+std::string generateDay3Input(int32_t height, int32_t width, double density,
+                              uint64_t seed) {
+  /**
+   * Each cell starts a number (1-3 digits) or a symbol with probability
+   * `density`. A number is always followed by a `.` so that neighboring
+   * numbers do not run together.
+   **/
+  Rng rng{seed};
+  std::string retInput;
+  retInput.reserve(static_cast<size_t>(height) * (width + 1));
+
+  for (int32_t i{0}; i < height; i++) {
+    std::string row(width, '.');
+
+    for (int32_t j{0}; j < width; j++) {
+      if (!rng.chance(density)) {
+        continue;
+      }
+
+      if (rng.chance(0.7)) {
+        const int32_t nDigits{static_cast<int32_t>(rng.uniform(1, 3))};
+
+        // Not enough room left in the row for this number
+        if (j + nDigits > width) {
+          continue;
+        }
+
+        row[j] = static_cast<char>('1' + rng.uniform(0, 8));
+        for (int32_t d{1}; d < nDigits; d++) {
+          row[j + d] = static_cast<char>('0' + rng.uniform(0, 9));
+        }
+
+        // Skip past the number and its trailing `.`
+        j += nDigits;
+      } else {
+        row[j] = SYMBOLS[rng.uniform(0, SYMBOLS.size() - 1)];
+      }
+    }
+
+    retInput.append(row);
+    retInput.push_back('\n');
+  }
+
+  return retInput;
+}
+
+std::string generateDay4Input(int64_t nCards, int32_t maxMatches,
+                              double winRate, uint64_t seed) {
+  /**
+   * Every card has 10 winning and 25 trial numbers in [1, 99]. A card has
+   * any matches at all with probability `winRate`, in which case the number
+   * of matches is uniform in [1, `maxMatches`]. Keeping `winRate *
+   * maxMatches` small keeps the part B copy counts from overflowing.
+   **/
+  const int32_t N_WINNING{10};
+  const int32_t N_TRIAL{25};
+
+  Rng rng{seed};
+  std::string retInput;
+  retInput.reserve(nCards * 128);
+
+  const int32_t idWidth{static_cast<int32_t>(std::to_string(nCards).size())};
+  maxMatches = std::clamp(maxMatches, 0, N_WINNING);
+
+  auto appendNumber{[&retInput](int32_t number) {
+    retInput.append(number < 10 ? "  " : " ");
+    retInput.append(std::to_string(number));
+  }};
+
+  for (int64_t cardId{1}; cardId <= nCards; cardId++) {
+    const std::string id{std::to_string(cardId)};
+    retInput.append("Card ");
+    retInput.append(idWidth - id.size(), ' ');
+    retInput.append(id + ":");
+
+    // Draw `N_WINNING + N_TRIAL` distinct numbers. The first `N_WINNING` are
+    // the winning numbers, and the trial numbers reuse `nMatches` of them
+    std::vector<int32_t> pool(99);
+    for (int32_t n{0}; n < 99; n++) {
+      pool[n] = n + 1;
+    }
+    rng.shuffle(pool);
+
+    const int32_t nMatches{static_cast<int32_t>(
+        maxMatches > 0 && rng.chance(winRate) ? rng.uniform(1, maxMatches)
+                                              : 0)};
+
+    std::vector<int32_t> trial(pool.begin(), pool.begin() + nMatches);
+    trial.insert(trial.end(), pool.begin() + N_WINNING,
+                 pool.begin() + N_WINNING + (N_TRIAL - nMatches));
+    rng.shuffle(trial);
+
+    for (int32_t n{0}; n < N_WINNING; n++) {
+      appendNumber(pool[n]);
+    }
+    retInput.append(" |");
+    for (const int32_t number : trial) {
+      appendNumber(number);
+    }
+
+    retInput.push_back('\n');
+  }
+
+  return retInput;
+}
+
+std::string generateDay5Input(int32_t nRangesPerMap, int32_t nSeedRanges,
+                              uint64_t seed) {
+  /**
+   * Each map partitions its source domain into `nRangesPerMap` segments,
+   * drops about a tenth of them (those map to themselves), and lays the rest
+   * out contiguously in a shuffled order on the destination side. The lines
+   * are emitted in a random order, like the real almanacs.
+   **/
+  const int64_t DOMAIN{int64_t{1} << 32};
+
+  Rng rng{seed};
+  std::string retInput;
+  retInput.reserve(static_cast<size_t>(nRangesPerMap) * 7 * 36);
+
+  retInput.append("seeds:");
+  for (int32_t s{0}; s < nSeedRanges; s++) {
+    const int64_t maxLength{std::max<int64_t>(1, DOMAIN / (4 * nSeedRanges))};
+    retInput.push_back(' ');
+    retInput.append(std::to_string(rng.uniform(0, DOMAIN - 1)));
+    retInput.push_back(' ');
+    retInput.append(std::to_string(rng.uniform(1, maxLength)));
+  }
+  retInput.push_back('\n');
+
+  for (size_t m{0}; m + 1 < ALMANAC_CATEGORIES.size(); m++) {
+    retInput.append("\n");
+    retInput.append(ALMANAC_CATEGORIES[m]);
+    retInput.append("-to-");
+    retInput.append(ALMANAC_CATEGORIES[m + 1]);
+    retInput.append(" map:\n");
+
+    const int64_t meanLength{std::max<int64_t>(1, DOMAIN / nRangesPerMap)};
+
+    // Each segment is (source, length)
+    std::vector<std::pair<int64_t, int64_t>> segments;
+    int64_t source{rng.uniform(0, meanLength)};
+    for (int32_t r{0}; r < nRangesPerMap; r++) {
+      const int64_t length{rng.uniform(1, 2 * meanLength - 1)};
+      if (!rng.chance(0.1)) {
+        segments.emplace_back(source, length);
+      }
+      source += length;
+    }
+
+    // Lay the segments out on the destination side in a shuffled order
+    std::vector<int32_t> order(segments.size());
+    for (size_t r{0}; r < order.size(); r++) {
+      order[r] = static_cast<int32_t>(r);
+    }
+    rng.shuffle(order);
+
+    std::vector<int64_t> destinations(segments.size());
+    int64_t destination{rng.uniform(0, meanLength)};
+    for (const int32_t r : order) {
+      destinations[r] = destination;
+      destination += segments[r].second;
+    }
+
+    // Emit the lines in yet another order
+    rng.shuffle(order);
+    for (const int32_t r : order) {
+      retInput.append(std::to_string(destinations[r]) + " " +
+                      std::to_string(segments[r].first) + " " +
+                      std::to_string(segments[r].second) + "\n");
+    }
+  }
+
+  return retInput;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Synthetic input generators. Each generator is deterministic for a given
+// `seed` and produces an input that the corresponding `dayN` binary accepts.
+
+std::string generateDay1Input(int64_t nLines, uint64_t seed);
+
+std::string generateDay2Input(int64_t nGames, uint64_t seed);
+
+std::string generateDay3Input(int32_t height, int32_t width, double density,
+                              uint64_t seed);
+
+std::string generateDay4Input(int64_t nCards, int32_t maxMatches,
+                              double winRate, uint64_t seed);
+
+std::string generateDay5Input(int32_t nRangesPerMap, int32_t nSeedRanges,
+                              uint64_t seed);
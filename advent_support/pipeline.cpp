@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "fileio.h"
+#include "pipeline.h"
+#include "profiling.h"
+#include "thread_pool.h"
+
+namespace {
+
+// Set when the stage just resumed on this thread ran to completion
+thread_local bool stageCompleted{false};
+
+Generator<std::string_view> splitChunk(std::string_view chunk,
+                                       std::string &carry) {
+  /**
+   * The complete lines of `chunk`. A line straddling two chunks starts in
+   * `carry`, which holds the incomplete last line afterwards.
+   **/
+  size_t lineStart{0};
+  size_t lineEnd{chunk.find('\n')};
+
+  while (lineEnd != std::string_view::npos) {
+    if (carry.empty()) {
+      co_yield chunk.substr(lineStart, lineEnd - lineStart);
+    } else {
+      carry.append(chunk, lineStart, lineEnd - lineStart);
+      co_yield std::string_view{carry};
+      carry.clear();
+    }
+
+    lineStart = lineEnd + 1;
+    lineEnd = chunk.find('\n', lineStart);
+  }
+
+  carry.append(chunk, lineStart);
+}
+
+} // namespace
+
+ThreadPool &pipelinePool() {
+  static ThreadPool pool{std::clamp(
+      static_cast<int32_t>(std::thread::hardware_concurrency()), 1,
+      PIPELINE_MAX_THREADS)};
+  return pool;
+}
+
+void Stage::promise_type::FinalAwaiter::await_suspend(
+    std::coroutine_handle<promise_type> handle) noexcept {
+  // The pipeline hears of it once the stage's span ended, see `resume`
+  handle.destroy();
+  stageCompleted = true;
+}
+
+void Stage::promise_type::unhandled_exception() {
+  mPipeline->fail(std::current_exception());
+}
+
+Pipeline::~Pipeline() {
+  try {
+    wait();
+  } catch (...) {
+    // Only reached when unwinding past a pipeline nobody waited for
+  }
+}
+
+void Pipeline::spawn(Stage stage, const char *name) {
+  const Stage::Handle handle{std::exchange(stage.mHandle, nullptr)};
+  handle.promise().mPipeline = this;
+  handle.promise().mName = name;
+
+  {
+    std::lock_guard<std::mutex> lock{mMutex};
+    mNRunning++;
+  }
+  schedule(handle);
+}
+
+void Pipeline::spawnThread(std::function<void()> source, const char *name) {
+  mThreads.emplace_back([this, source{std::move(source)}, name]() {
+    ADVENT_PROFILE_ADOPT_SCOPE(mProfileScope);
+    ADVENT_PROFILE_SCOPE(name);
+    try {
+      source();
+    } catch (const PipelineCancelled &) {
+      // Another stage failed first
+    } catch (...) {
+      fail(std::current_exception());
+    }
+  });
+}
+
+void Pipeline::wait() {
+  for (std::thread &thread : mThreads) {
+    thread.join();
+  }
+  mThreads.clear();
+
+  std::unique_lock<std::mutex> lock{mMutex};
+  mStageFinished.wait(lock, [this]() { return mNRunning == 0; });
+
+  if (mError) {
+    std::rethrow_exception(std::exchange(mError, nullptr));
+  }
+}
+
+void Pipeline::fail(std::exception_ptr error) {
+  {
+    std::lock_guard<std::mutex> lock{mMutex};
+    if (mError) {
+      return;
+    }
+    mError = std::move(error);
+  }
+
+  for (const std::unique_ptr<ChannelBase> &channel : mChannels) {
+    channel->cancel();
+  }
+}
+
+void Pipeline::schedule(Stage::Handle handle) {
+  mPool.submit([this, handle]() { resume(handle); });
+}
+
+void Pipeline::resume(Stage::Handle handle) {
+  {
+    ADVENT_PROFILE_ADOPT_SCOPE(mProfileScope);
+    ADVENT_PROFILE_SCOPE(handle.promise().mName);
+    handle.resume();
+  }
+
+  // Only now that the span ended: once the last stage finished, `wait` may
+  // return, and the span enclosing the pipeline end
+  if (std::exchange(stageCompleted, false)) {
+    stageFinished();
+  }
+}
+
+void Pipeline::stageFinished() {
+  // Notified under the lock: `wait` may return, and the pipeline go away, as
+  // soon as the lock is released
+  std::lock_guard<std::mutex> lock{mMutex};
+  mNRunning--;
+  mStageFinished.notify_all();
+}
+
+void readChunks(Pipeline &pipeline, const std::string &filename,
+                Channel<std::string> &chunks) {
+  pipeline.spawnThread(
+      [filename, &chunks]() {
+        forEachChunk(filename, [&chunks](std::string_view chunk) {
+          if (!chunks.pushBlocking(std::string{chunk})) {
+            throw PipelineCancelled{};
+          }
+        });
+        chunks.close();
+      },
+      "read");
+}
+
+Stage splitLines(Channel<std::string> &chunks, Channel<LineBatch> &batches) {
+  std::string carry;
+  LineBatch batch{0, {}};
+
+  while (std::optional<std::string> chunk{co_await chunks.pop()}) {
+    for (std::string_view line : splitChunk(*chunk, carry)) {
+      batch.lines.emplace_back(line);
+      if (batch.lines.size() < PIPELINE_BATCH_LINES) {
+        continue;
+      }
+
+      const int64_t nextLine{batch.firstLine +
+                             static_cast<int64_t>(batch.lines.size())};
+      ADVENT_PROFILE_COUNT("pipeline.lineBatches", 1);
+      if (!co_await batches.push(std::exchange(batch, {nextLine, {}}))) {
+        co_return;
+      }
+    }
+  }
+
+  if (!carry.empty()) {
+    batch.lines.push_back(std::move(carry));
+  }
+  if (!batch.lines.empty()) {
+    ADVENT_PROFILE_COUNT("pipeline.lineBatches", 1);
+    co_await batches.push(std::move(batch));
+  }
+  batches.close();
+}
@@ -0,0 +1,513 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "profiling.h"
+#include "thread_pool.h"
+
+// Coroutine pipelines: stages connected by bounded channels, resumed on a
+// small thread pool. A stage waiting on a full or an empty channel suspends
+// instead of blocking its thread, so every stage runs at once on however few
+// threads there are, and the data in flight is bounded by the channels'
+// capacities.
+//
+// `runLinePipeline` and `runLineBatchPipeline` wire up the usual read -> split
+// lines -> parse -> reduce pipeline of the line-oriented days.
+
+// Channel capacity, in batches, of the pipelines `runLineBatchPipeline` builds
+constexpr size_t PIPELINE_QUEUE_DEPTH{4};
+
+// Lines per batch handed from the splitter to the parsers
+constexpr size_t PIPELINE_BATCH_LINES{4096};
+
+// Upper bound of the threads of `pipelinePool()`
+constexpr int32_t PIPELINE_MAX_THREADS{4};
+
+// The pool that pipelines run their stages on by default
+ThreadPool &pipelinePool();
+
+template <typename T> class Generator {
+  /**
+   * A lazily evaluated sequence, produced by a coroutine that `co_yield`s
+   * each element when the consumer asks for the next one.
+   **/
+public:
+  struct promise_type {
+    const T *mCurrent{nullptr};
+    std::exception_ptr mError{};
+
+    Generator get_return_object() {
+      return Generator{
+          std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+
+    // The yielded value outlives the suspension, it is part of the frame
+    std::suspend_always yield_value(const T &value) noexcept {
+      mCurrent = std::addressof(value);
+      return {};
+    }
+    void return_void() {}
+    void unhandled_exception() { mError = std::current_exception(); }
+  };
+
+  using Handle = std::coroutine_handle<promise_type>;
+
+  class Iterator {
+  public:
+    explicit Iterator(Handle handle) : mHandle{handle} {}
+
+    const T &operator*() const { return *mHandle.promise().mCurrent; }
+    Iterator &operator++() {
+      advance(mHandle);
+      return *this;
+    }
+    bool operator==(std::default_sentinel_t) const { return mHandle.done(); }
+
+  private:
+    Handle mHandle;
+  };
+
+  explicit Generator(Handle handle) : mHandle{handle} {}
+  ~Generator() {
+    if (mHandle) {
+      mHandle.destroy();
+    }
+  }
+
+  Generator(Generator &&other) noexcept
+      : mHandle{std::exchange(other.mHandle, nullptr)} {}
+  Generator(const Generator &) = delete;
+  Generator &operator=(const Generator &) = delete;
+
+  Iterator begin() {
+    advance(mHandle);
+    return Iterator{mHandle};
+  }
+  std::default_sentinel_t end() const { return {}; }
+
+private:
+  static void advance(Handle handle) {
+    handle.resume();
+    if (handle.promise().mError) {
+      std::rethrow_exception(handle.promise().mError);
+    }
+  }
+
+  Handle mHandle;
+};
+
+class Pipeline;
+template <typename T> class Channel;
+
+class Stage {
+  /**
+   * The coroutine of a pipeline stage. It does not start until
+   * `Pipeline::spawn`, and an exception escaping it cancels the pipeline.
+   **/
+public:
+  struct promise_type {
+    Pipeline *mPipeline{nullptr};
+    // The span each resumption of the stage is profiled as
+    const char *mName{"stage"};
+
+    Stage get_return_object() {
+      return Stage{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // The frame destroys itself once the stage is done
+    struct FinalAwaiter {
+      bool await_ready() noexcept { return false; }
+      void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+      void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void return_void() {}
+    void unhandled_exception();
+  };
+
+  using Handle = std::coroutine_handle<promise_type>;
+
+  explicit Stage(Handle handle) : mHandle{handle} {}
+  ~Stage() {
+    if (mHandle) {
+      mHandle.destroy();
+    }
+  }
+
+  Stage(Stage &&other) noexcept
+      : mHandle{std::exchange(other.mHandle, nullptr)} {}
+  Stage(const Stage &) = delete;
+  Stage &operator=(const Stage &) = delete;
+
+private:
+  friend class Pipeline;
+
+  Handle mHandle;
+};
+
+// Thrown out of a source thread's reads once the pipeline was cancelled
+struct PipelineCancelled {};
+
+class ChannelBase {
+public:
+  virtual ~ChannelBase() = default;
+
+  // Wake up every waiting stage, and make every further push and pop fail
+  virtual void cancel() = 0;
+};
+
+class Pipeline {
+  /**
+   * Owns the channels between the stages and tracks the stages until they
+   * are done. The first failure of any stage cancels every channel, so that
+   * the other stages wind down instead of waiting forever.
+   **/
+public:
+  // The stages and threads are profiled under the span the pipeline is built
+  // in, which has to last until `wait` returns
+  explicit Pipeline(ThreadPool &pool = pipelinePool()) : mPool{pool} {}
+
+  // Waits for the stages still running
+  ~Pipeline();
+
+  Pipeline(const Pipeline &) = delete;
+  Pipeline &operator=(const Pipeline &) = delete;
+
+  int32_t nThreads() const { return mPool.size(); }
+
+  // A channel holding up to `capacity` values, closed once each of its
+  // `nProducers` closed it
+  template <typename T>
+  Channel<T> &makeChannel(size_t capacity, int32_t nProducers = 1);
+
+  // Start `stage` on the pool, profiled as `name`
+  void spawn(Stage stage, const char *name);
+
+  // Run `source` on a thread of its own, for work that blocks, such as reads,
+  // profiled as `name`
+  void spawnThread(std::function<void()> source, const char *name);
+
+  // Wait for every stage and thread, and rethrow the first failure
+  void wait();
+
+  void fail(std::exception_ptr error);
+
+  // Resume `handle` on the pool
+  void schedule(Stage::Handle handle);
+
+private:
+  void resume(Stage::Handle handle);
+
+  void stageFinished();
+
+  ThreadPool &mPool;
+  const ScopedTimer *const mProfileScope{ADVENT_PROFILE_CURRENT_SCOPE()};
+  std::vector<std::unique_ptr<ChannelBase>> mChannels{};
+  std::vector<std::thread> mThreads{};
+
+  std::mutex mMutex{};
+  std::condition_variable mStageFinished{};
+  int32_t mNRunning{0};
+  std::exception_ptr mError{};
+};
+
+template <typename T> class Channel : public ChannelBase {
+  /**
+   * A bounded multi-producer, multi-consumer queue between stages.
+   * `co_await push(value)` suspends while the channel is full, and
+   * `co_await pop()` while it is empty. A waiting consumer is handed the
+   * value directly, and a waiting producer's value moves in as soon as there
+   * is room.
+   **/
+public:
+  Channel(Pipeline &pipeline, const size_t capacity, const int32_t nProducers)
+      : mPipeline{pipeline}, mCapacity{capacity}, mNOpenProducers{nProducers} {}
+
+  class PushAwaiter {
+  public:
+    PushAwaiter(Channel &channel, T value)
+        : mChannel{channel}, mValue{std::move(value)} {}
+
+    bool await_ready() { return false; }
+    bool await_suspend(Stage::Handle handle) {
+      mHandle = handle;
+      std::lock_guard<std::mutex> lock{mChannel.mMutex};
+      if (mChannel.tryPush(mValue, mPushed)) {
+        return false;
+      }
+      mChannel.mWaitingPushers.push_back(this);
+      return true;
+    }
+    // False once the pipeline was cancelled
+    bool await_resume() { return mPushed; }
+
+  private:
+    friend class Channel;
+
+    Channel &mChannel;
+    T mValue;
+    bool mPushed{false};
+    Stage::Handle mHandle{};
+  };
+
+  class PopAwaiter {
+  public:
+    explicit PopAwaiter(Channel &channel) : mChannel{channel} {}
+
+    bool await_ready() { return false; }
+    bool await_suspend(Stage::Handle handle) {
+      mHandle = handle;
+      std::lock_guard<std::mutex> lock{mChannel.mMutex};
+      if (mChannel.tryPop(mValue)) {
+        return false;
+      }
+      mChannel.mWaitingPoppers.push_back(this);
+      return true;
+    }
+    // Empty once every producer closed the channel and it was drained, or
+    // the pipeline was cancelled
+    std::optional<T> await_resume() { return std::move(mValue); }
+
+  private:
+    friend class Channel;
+
+    Channel &mChannel;
+    std::optional<T> mValue{};
+    Stage::Handle mHandle{};
+  };
+
+  PushAwaiter push(T value) { return PushAwaiter{*this, std::move(value)}; }
+  PopAwaiter pop() { return PopAwaiter{*this}; }
+
+  // `push` for threads outside the pipeline, blocking while the channel is
+  // full. False once the pipeline was cancelled
+  bool pushBlocking(T value) {
+    std::unique_lock<std::mutex> lock{mMutex};
+    mSpaceAvailable.wait(lock, [this]() {
+      return mCancelled || !mWaitingPoppers.empty() ||
+             mItems.size() < mCapacity;
+    });
+
+    bool retPushed{false};
+    tryPush(value, retPushed);
+    return retPushed;
+  }
+
+  // One of the producers is done
+  void close() {
+    std::lock_guard<std::mutex> lock{mMutex};
+    if (--mNOpenProducers > 0) {
+      return;
+    }
+
+    // Nothing is left for the waiting consumers
+    for (PopAwaiter *popper : mWaitingPoppers) {
+      mPipeline.schedule(popper->mHandle);
+    }
+    mWaitingPoppers.clear();
+  }
+
+  void cancel() override {
+    std::lock_guard<std::mutex> lock{mMutex};
+    mCancelled = true;
+    mItems.clear();
+
+    for (PushAwaiter *pusher : mWaitingPushers) {
+      mPipeline.schedule(pusher->mHandle);
+    }
+    for (PopAwaiter *popper : mWaitingPoppers) {
+      mPipeline.schedule(popper->mHandle);
+    }
+    mWaitingPushers.clear();
+    mWaitingPoppers.clear();
+    mSpaceAvailable.notify_all();
+  }
+
+private:
+  // Both with `mMutex` held. The resumed stages continue on the pool
+  bool tryPush(T &value, bool &retPushed) {
+    if (mCancelled) {
+      retPushed = false;
+      return true;
+    }
+
+    if (!mWaitingPoppers.empty()) {
+      PopAwaiter *popper{mWaitingPoppers.front()};
+      mWaitingPoppers.pop_front();
+      popper->mValue.emplace(std::move(value));
+      mPipeline.schedule(popper->mHandle);
+    } else if (mItems.size() < mCapacity) {
+      mItems.push_back(std::move(value));
+    } else {
+      return false;
+    }
+
+    retPushed = true;
+    return true;
+  }
+
+  bool tryPop(std::optional<T> &retValue) {
+    if (mCancelled) {
+      return true;
+    }
+    if (mItems.empty()) {
+      return mNOpenProducers == 0;
+    }
+
+    retValue.emplace(std::move(mItems.front()));
+    mItems.pop_front();
+
+    // The room just freed goes to a waiting producer, if there is one
+    if (!mWaitingPushers.empty()) {
+      PushAwaiter *pusher{mWaitingPushers.front()};
+      mWaitingPushers.pop_front();
+      mItems.push_back(std::move(pusher->mValue));
+      pusher->mPushed = true;
+      mPipeline.schedule(pusher->mHandle);
+    } else {
+      mSpaceAvailable.notify_one();
+    }
+
+    return true;
+  }
+
+  Pipeline &mPipeline;
+  const size_t mCapacity;
+  int32_t mNOpenProducers;
+  bool mCancelled{false};
+
+  std::mutex mMutex{};
+  std::condition_variable mSpaceAvailable{};
+  std::deque<T> mItems{};
+  std::deque<PushAwaiter *> mWaitingPushers{};
+  std::deque<PopAwaiter *> mWaitingPoppers{};
+};
+
+template <typename T>
+Channel<T> &Pipeline::makeChannel(const size_t capacity,
+                                  const int32_t nProducers) {
+  auto channel{std::make_unique<Channel<T>>(*this, capacity, nProducers)};
+  Channel<T> &retChannel{*channel};
+  mChannels.push_back(std::move(channel));
+  return retChannel;
+}
+
+/* The stages of `runLineBatchPipeline` */
+
+struct LineBatch {
+  // The index of the first line in the file, from 0
+  int64_t firstLine;
+  std::vector<std::string> lines;
+};
+
+// What a parser made of the lines of a `LineBatch`
+template <typename Result> struct ParsedBatch {
+  int64_t firstLine;
+  Result result;
+};
+
+// Read `filename` on a thread of its own, into chunks, through the file cache
+// if it is enabled. The stages `runLineBatchPipeline` starts are profiled as
+// `read`, `split`, `parse` and `reduce`
+void readChunks(Pipeline &pipeline, const std::string &filename,
+                Channel<std::string> &chunks);
+
+// Split the chunks into batches of at most `PIPELINE_BATCH_LINES` lines, the
+// same way `std::getline` would
+Stage splitLines(Channel<std::string> &chunks, Channel<LineBatch> &batches);
+
+template <typename Result, typename ParseBatch>
+Stage parseBatches(Channel<LineBatch> &batches,
+                   Channel<ParsedBatch<Result>> &parsed,
+                   ParseBatch parseBatch) {
+  while (std::optional<LineBatch> batch{co_await batches.pop()}) {
+    ParsedBatch<Result> result{batch->firstLine, parseBatch(batch->lines)};
+    if (!co_await parsed.push(std::move(result))) {
+      co_return;
+    }
+  }
+
+  parsed.close();
+}
+
+template <typename Result, typename Reduce>
+Stage reduceBatches(Channel<ParsedBatch<Result>> &parsed, Reduce reduce) {
+  while (std::optional<ParsedBatch<Result>> batch{co_await parsed.pop()}) {
+    reduce(batch->firstLine, std::move(batch->result));
+  }
+}
+
+template <typename ParseBatch, typename Reduce>
+void runLineBatchPipeline(const std::string &filename, ParseBatch parseBatch,
+                          Reduce reduce) {
+  /**
+   * Read `filename`, split it into batches of lines, `parseBatch(lines)` each
+   * batch and `reduce(firstLine, result)` every result. There is one parser
+   * per thread of the pool, so `parseBatch` has to be safe to call
+   * concurrently, and the results reach `reduce` one at a time, but not
+   * necessarily in line order.
+   **/
+  using Result =
+      std::invoke_result_t<ParseBatch &, const std::vector<std::string> &>;
+
+  Pipeline pipeline;
+  const int32_t nParsers{pipeline.nThreads()};
+
+  auto &chunks{pipeline.makeChannel<std::string>(PIPELINE_QUEUE_DEPTH)};
+  auto &lines{pipeline.makeChannel<LineBatch>(PIPELINE_QUEUE_DEPTH)};
+  auto &parsed{pipeline.makeChannel<ParsedBatch<Result>>(PIPELINE_QUEUE_DEPTH,
+                                                         nParsers)};
+
+  readChunks(pipeline, filename, chunks);
+  pipeline.spawn(splitLines(chunks, lines), "split");
+  for (int32_t i{0}; i < nParsers; i++) {
+    pipeline.spawn(parseBatches<Result>(lines, parsed, parseBatch), "parse");
+  }
+  pipeline.spawn(reduceBatches<Result>(parsed, std::move(reduce)), "reduce");
+
+  pipeline.wait();
+}
+
+template <typename Parse, typename Reduce>
+void runLinePipeline(const std::string &filename, Parse parse,
+                     Reduce reduce) {
+  /**
+   * `runLineBatchPipeline`, with `parse(line)` turning each line into a
+   * record and `reduce(lineIndex, record)` called for every record.
+   **/
+  using Record = std::invoke_result_t<Parse &, const std::string &>;
+
+  runLineBatchPipeline(
+      filename,
+      [parse](const std::vector<std::string> &lines) mutable {
+        std::vector<Record> retRecords;
+        retRecords.reserve(lines.size());
+        for (const std::string &line : lines) {
+          retRecords.push_back(parse(line));
+        }
+        return retRecords;
+      },
+      [&reduce](const int64_t firstLine, std::vector<Record> records) {
+        for (size_t i{0}; i < records.size(); i++) {
+          reduce(firstLine + static_cast<int64_t>(i), std::move(records[i]));
+        }
+      });
+}
@@ -0,0 +1,438 @@
+#ifdef ADVENT_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef ADVENT_PROFILE_RDTSC
+#include <x86intrin.h>
+#endif
+
+#include "profiling.h"
+
+namespace {
+
+uint64_t readClock() {
+#ifdef ADVENT_PROFILE_RDTSC
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+int64_t steadyNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Recorded as a span ends, without allocating: the paths of the spans are only
+// put together when the report is written
+struct Span {
+  const char *name;
+  uint64_t id;
+  // 0 for a span outside of any other
+  uint64_t parentId;
+  uint64_t start;
+  uint64_t end;
+  int32_t threadId;
+#ifdef ADVENT_PROFILE_ALLOC
+  int64_t nAllocations;
+  int64_t nBytes;
+  // Peak live bytes above those live when the span started
+  int64_t peakLiveBytes;
+  int64_t peakRssBytes;
+#endif
+};
+
+int32_t currentThreadId() {
+  static std::atomic<int32_t> nextThreadId{0};
+  thread_local const int32_t threadId{nextThreadId.fetch_add(1)};
+  return threadId;
+}
+
+thread_local const ScopedTimer *currentTimer{nullptr};
+
+// The spans ended on this thread since it started
+thread_local uint64_t nThreadSpans{0};
+
+struct SpanBlock {
+  /**
+   * A block of the spans one thread recorded. Blocks come from `malloc`, so
+   * that the allocation tracking does not attribute them to the spans, and
+   * are chained into the profiler's list, which outlives the threads.
+   **/
+  static constexpr int64_t CAPACITY{4096};
+
+  Span spans[CAPACITY];
+  // Published with release order once the span is written
+  std::atomic<int64_t> nSpans{0};
+  SpanBlock *next{nullptr};
+};
+
+// The block this thread records into. Constant initialized, so that a thread
+// recording its first span runs no constructor
+thread_local SpanBlock *threadSpans{nullptr};
+
+std::string escapeJson(const std::string &text) {
+  // Counter names can be built at runtime, and hold anything
+  std::string retEscaped;
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      retEscaped.push_back('\\');
+      retEscaped.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      constexpr char HEX_DIGITS[]{"0123456789abcdef"};
+      retEscaped.append("\\u00");
+      retEscaped.push_back(HEX_DIGITS[(c >> 4) & 0xf]);
+      retEscaped.push_back(HEX_DIGITS[c & 0xf]);
+    } else {
+      retEscaped.push_back(c);
+    }
+  }
+  return retEscaped;
+}
+
+class Profiler {
+  /**
+   * Process-wide sink for spans and counters. Reports on destruction, i.e.
+   * after `main` returns.
+   **/
+public:
+  Profiler() : mStartClock{readClock()}, mStartSteady{steadyNanoseconds()} {}
+
+  Profiler(const Profiler &) = delete;
+  Profiler &operator=(const Profiler &) = delete;
+
+  ~Profiler() {
+    collectSpans();
+
+    const char *reportEnv{std::getenv("ADVENT_PROFILE_REPORT")};
+    const char *traceEnv{std::getenv("ADVENT_PROFILE_TRACE")};
+
+    if (reportEnv != nullptr && std::string{reportEnv} != "0") {
+      printReport(std::cerr);
+    }
+
+    if (traceEnv != nullptr) {
+      std::ofstream traceFile{traceEnv};
+      if (!traceFile.is_open()) {
+        std::cerr << "Error opening trace file: " << traceEnv << std::endl;
+        return;
+      }
+      writeChromeTrace(traceFile);
+    }
+  }
+
+  void recordSpan(const Span &span) {
+    if (threadSpans == nullptr ||
+        threadSpans->nSpans.load(std::memory_order_relaxed) ==
+            SpanBlock::CAPACITY) {
+      void *memory{std::malloc(sizeof(SpanBlock))};
+      if (memory == nullptr) {
+        return;
+      }
+      SpanBlock *const block{new (memory) SpanBlock};
+
+      std::lock_guard<std::mutex> lock{mMutex};
+      block->next = mBlocks;
+      mBlocks = block;
+      threadSpans = block;
+    }
+
+    const int64_t index{threadSpans->nSpans.load(std::memory_order_relaxed)};
+    threadSpans->spans[index] = span;
+    threadSpans->nSpans.store(index + 1, std::memory_order_release);
+  }
+
+  void registerCounter(ProfileCounter *counter) {
+    std::lock_guard<std::mutex> lock{mMutex};
+    mCounters.push_back(counter);
+  }
+
+  void retireCounter(ProfileCounter *counter) {
+    // Static counters may be destroyed before the report is written, so fold
+    // their value into the dynamic counters
+    std::lock_guard<std::mutex> lock{mMutex};
+    mCounters.erase(std::remove(mCounters.begin(), mCounters.end(), counter),
+                    mCounters.end());
+    mDynamicCounters[counter->name()] += counter->value();
+  }
+
+  void addToDynamicCounter(const std::string &name, int64_t n) {
+    std::lock_guard<std::mutex> lock{mMutex};
+    mDynamicCounters[name] += n;
+  }
+
+private:
+  void collectSpans() {
+    /**
+     * Gather the spans of every thread, in start order, and name each one
+     * with the path of the spans enclosing it, which also gives its depth.
+     * A parent that never ended is left out of the path.
+     **/
+    std::lock_guard<std::mutex> lock{mMutex};
+    for (SpanBlock *block{mBlocks}; block != nullptr;) {
+      const int64_t nSpans{block->nSpans.load(std::memory_order_acquire)};
+      mSpans.insert(mSpans.end(), block->spans, block->spans + nSpans);
+
+      SpanBlock *const next{block->next};
+      block->~SpanBlock();
+      std::free(block);
+      block = next;
+    }
+    mBlocks = nullptr;
+
+    std::sort(mSpans.begin(), mSpans.end(),
+              [](const Span &a, const Span &b) { return a.start < b.start; });
+
+    std::unordered_map<uint64_t, const Span *> byId;
+    for (const Span &span : mSpans) {
+      byId[span.id] = &span;
+    }
+
+    mPaths.resize(mSpans.size());
+    mDepths.resize(mSpans.size());
+    for (size_t i{0}; i < mSpans.size(); i++) {
+      std::string path{mSpans[i].name};
+      int32_t depth{0};
+      for (auto it{byId.find(mSpans[i].parentId)}; it != byId.end();
+           it = byId.find(it->second->parentId)) {
+        path = std::string{it->second->name} + "/" + path;
+        depth++;
+      }
+      mPaths[i] = std::move(path);
+      mDepths[i] = depth;
+    }
+  }
+
+  double nanosecondsPerTick() const {
+    // Calibrate the clock against `steady_clock` over the whole run. This is
+    // exactly 1 for the `steady_clock` backend
+    const double ticks{static_cast<double>(readClock() - mStartClock)};
+    const double elapsed{
+        static_cast<double>(steadyNanoseconds() - mStartSteady)};
+
+    return ticks > 0 ? elapsed / ticks : 1.0;
+  }
+
+  std::map<std::string, int64_t> collectCounters() const {
+    std::map<std::string, int64_t> retCounters{mDynamicCounters};
+    for (const ProfileCounter *counter : mCounters) {
+      retCounters[counter->name()] += counter->value();
+    }
+
+#ifdef ADVENT_PROFILE_ALLOC
+    const AllocationStats process{processAllocationStats()};
+    retCounters["alloc.allocations"] = process.nAllocations;
+    retCounters["alloc.bytes"] = process.nBytes;
+    retCounters["alloc.peakLiveBytes"] = process.peakLiveBytes;
+    retCounters["alloc.peakRssBytes"] = peakRssBytes();
+#endif
+
+    return retCounters;
+  }
+
+  void printReport(std::ostream &out) {
+    const double nsPerTick{nanosecondsPerTick()};
+
+    struct Phase {
+      std::string name;
+      std::string path;
+      int32_t depth;
+      int64_t calls;
+      double totalMs;
+#ifdef ADVENT_PROFILE_ALLOC
+      int64_t nAllocations{0};
+      int64_t nBytes{0};
+      int64_t peakLiveBytes{0};
+      int64_t peakRssBytes{0};
+#endif
+    };
+
+    // Aggregate the spans by path, ordered by first occurrence
+    std::vector<Phase> phases;
+    for (size_t i{0}; i < mSpans.size(); i++) {
+      const Span &span{mSpans[i]};
+      auto it{std::find_if(phases.begin(), phases.end(),
+                           [this, i](const Phase &phase) {
+                             return phase.path == mPaths[i];
+                           })};
+      if (it == phases.end()) {
+        phases.push_back({span.name, mPaths[i], mDepths[i], 0, 0.0});
+        it = phases.end() - 1;
+      }
+
+      it->calls++;
+      it->totalMs += (span.end - span.start) * nsPerTick / 1e6;
+#ifdef ADVENT_PROFILE_ALLOC
+      it->nAllocations += span.nAllocations;
+      it->nBytes += span.nBytes;
+      it->peakLiveBytes = std::max(it->peakLiveBytes, span.peakLiveBytes);
+      it->peakRssBytes = std::max(it->peakRssBytes, span.peakRssBytes);
+#endif
+    }
+
+    out << "---- Profile ----" << std::endl;
+    out << std::left << std::setw(40) << "phase" << std::right
+        << std::setw(10) << "calls" << std::setw(14) << "total ms";
+#ifdef ADVENT_PROFILE_ALLOC
+    out << std::setw(12) << "allocs" << std::setw(14) << "bytes"
+        << std::setw(14) << "peak live" << std::setw(14) << "peak RSS";
+#endif
+    out << std::endl;
+    for (const Phase &phase : phases) {
+      out << std::left << std::setw(40)
+          << std::string(2 * phase.depth, ' ') + phase.name << std::right
+          << std::setw(10) << phase.calls << std::setw(14) << std::fixed
+          << std::setprecision(3) << phase.totalMs;
+#ifdef ADVENT_PROFILE_ALLOC
+      out << std::setw(12) << phase.nAllocations << std::setw(14)
+          << phase.nBytes << std::setw(14) << phase.peakLiveBytes
+          << std::setw(14) << phase.peakRssBytes;
+#endif
+      out << std::endl;
+    }
+
+    const std::map<std::string, int64_t> counters{collectCounters()};
+    if (!counters.empty()) {
+      out << std::left << std::setw(40) << "counter" << std::right
+          << std::setw(24) << "value" << std::endl;
+      for (const auto &[name, value] : counters) {
+        out << std::left << std::setw(40) << name << std::right
+            << std::setw(24) << value << std::endl;
+      }
+    }
+  }
+
+  void writeChromeTrace(std::ostream &out) const {
+    const double nsPerTick{nanosecondsPerTick()};
+    auto toMicroseconds{[&](uint64_t tick) {
+      return (tick - mStartClock) * nsPerTick / 1e3;
+    }};
+
+    out << "{\"traceEvents\":[";
+
+    bool first{true};
+    for (const Span &span : mSpans) {
+      out << (first ? "" : ",") << "\n{\"name\":\"" << escapeJson(span.name)
+          << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << span.threadId
+          << ",\"ts\":" << std::fixed << std::setprecision(3)
+          << toMicroseconds(span.start)
+          << ",\"dur\":" << (span.end - span.start) * nsPerTick / 1e3;
+#ifdef ADVENT_PROFILE_ALLOC
+      out << ",\"args\":{\"allocations\":" << span.nAllocations
+          << ",\"bytes\":" << span.nBytes
+          << ",\"peakLiveBytes\":" << span.peakLiveBytes << "}";
+#endif
+      out << "}";
+      first = false;
+    }
+
+    // Counters are emitted once, at the end of the trace
+    const double endTs{toMicroseconds(readClock())};
+    for (const auto &[name, value] : collectCounters()) {
+      out << (first ? "" : ",") << "\n{\"name\":\"" << escapeJson(name)
+          << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << endTs
+          << ",\"args\":{\"value\":" << value << "}}";
+      first = false;
+    }
+
+    out << "\n]}" << std::endl;
+  }
+
+  std::mutex mMutex{};
+  SpanBlock *mBlocks{nullptr};
+
+  // Filled in by `collectSpans`, in start order, with each span's path: the
+  // names of the spans enclosing it joined with `/`
+  std::vector<Span> mSpans{};
+  std::vector<std::string> mPaths{};
+  std::vector<int32_t> mDepths{};
+  std::vector<ProfileCounter *> mCounters{};
+  std::map<std::string, int64_t> mDynamicCounters{};
+  uint64_t mStartClock;
+  int64_t mStartSteady;
+};
+
+Profiler &profiler() {
+  static Profiler instance;
+  return instance;
+}
+
+// Make sure the `Profiler` is constructed before any span starts, so that it
+// also outlives all of them
+const Profiler &forceProfilerConstruction{profiler()};
+
+} // namespace
+
+ProfileCounter::ProfileCounter(const char *name) : mName{name} {
+  profiler().registerCounter(this);
+}
+
+ProfileCounter::~ProfileCounter() { profiler().retireCounter(this); }
+
+ScopedTimer::ScopedTimer(const char *name)
+    : mName{name}, mParent{currentTimer},
+      mId{static_cast<uint64_t>(currentThreadId()) << 40 | ++nThreadSpans},
+      mStart{readClock()} {
+  currentTimer = this;
+
+#ifdef ADVENT_PROFILE_ALLOC
+  // Track this span's own high-water mark, the parent's is restored when
+  // the span ends
+  AllocationStats &stats{threadAllocationStats()};
+  mAllocationsAtStart = stats;
+  stats.peakLiveBytes = stats.liveBytes;
+#endif
+}
+
+ScopedTimer::~ScopedTimer() {
+  const uint64_t end{readClock()};
+  currentTimer = mParent;
+  const uint64_t parentId{mParent != nullptr ? mParent->mId : 0};
+
+#ifdef ADVENT_PROFILE_ALLOC
+  AllocationStats &stats{threadAllocationStats()};
+  const int64_t peakLiveBytes{stats.peakLiveBytes -
+                              mAllocationsAtStart.liveBytes};
+  stats.peakLiveBytes =
+      std::max(stats.peakLiveBytes, mAllocationsAtStart.peakLiveBytes);
+
+  profiler().recordSpan({mName, mId, parentId, mStart, end, currentThreadId(),
+                         stats.nAllocations - mAllocationsAtStart.nAllocations,
+                         stats.nBytes - mAllocationsAtStart.nBytes,
+                         peakLiveBytes, peakRssBytes()});
+#else
+  profiler().recordSpan(
+      {mName, mId, parentId, mStart, end, currentThreadId()});
+#endif
+}
+
+AdoptedProfileScope::AdoptedProfileScope(const ScopedTimer *parent)
+    : mPrevious{std::exchange(currentTimer, parent)} {}
+
+AdoptedProfileScope::~AdoptedProfileScope() { currentTimer = mPrevious; }
+
+const ScopedTimer *currentProfileScope() { return currentTimer; }
+
+void addToProfileCounter(const std::string &name, int64_t n) {
+  profiler().addToDynamicCounter(name, n);
+}
+
+#endif
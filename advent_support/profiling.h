@@ -0,0 +1,123 @@
+#pragma once
+
+// Lightweight scoped timers and counters for the hot paths.
+//
+// Everything here compiles to nothing unless `ADVENT_PROFILE` is defined
+// (`make PROFILE=1`, or `make PROFILE=rdtsc` for the `rdtsc` clock backend).
+// `make PROFILE=alloc` also counts the allocations, bytes, peak live bytes
+// and peak RSS of every span, see `alloc_tracking.h`.
+// Spans nest per thread. `ADVENT_PROFILE_CURRENT_SCOPE()` captures the
+// innermost span to hand to another thread, where `ADVENT_PROFILE_ADOPT_SCOPE`
+// nests the spans started there under it.
+// When enabled, the collected data is reported at exit:
+//   - `ADVENT_PROFILE_REPORT=1` prints a per-phase breakdown to stderr
+//   - `ADVENT_PROFILE_TRACE=<path>` writes a Chrome trace JSON to `<path>`
+
+#ifdef ADVENT_PROFILE
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "alloc_tracking.h"
+
+class ProfileCounter {
+public:
+  explicit ProfileCounter(const char *name);
+  ~ProfileCounter();
+
+  ProfileCounter(const ProfileCounter &) = delete;
+  ProfileCounter &operator=(const ProfileCounter &) = delete;
+
+  void add(int64_t n) { mValue.fetch_add(n, std::memory_order_relaxed); }
+
+  const char *name() const { return mName; }
+
+  int64_t value() const { return mValue.load(std::memory_order_relaxed); }
+
+private:
+  const char *mName;
+  std::atomic<int64_t> mValue{0};
+};
+
+class ScopedTimer {
+  /**
+   * Times the enclosing scope and records it as a span named `name`, into a
+   * buffer of the calling thread. Neither takes a lock nor allocates, but
+   * once every few thousand spans.
+   **/
+public:
+  explicit ScopedTimer(const char *name);
+  ~ScopedTimer();
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  const char *mName;
+  const ScopedTimer *mParent;
+  // Unique over the process, for the report to find the parent of a span
+  // once the span ended
+  uint64_t mId;
+  uint64_t mStart;
+#ifdef ADVENT_PROFILE_ALLOC
+  // This thread's allocations when the span started
+  AllocationStats mAllocationsAtStart{};
+#endif
+};
+
+class AdoptedProfileScope {
+  /**
+   * Nests the spans the calling thread starts, until this is destroyed,
+   * under `parent`: a span of another thread, which has to outlive them.
+   * This is how work handed to other threads is attributed to the span that
+   * handed it out.
+   **/
+public:
+  explicit AdoptedProfileScope(const ScopedTimer *parent);
+  ~AdoptedProfileScope();
+
+  AdoptedProfileScope(const AdoptedProfileScope &) = delete;
+  AdoptedProfileScope &operator=(const AdoptedProfileScope &) = delete;
+
+private:
+  const ScopedTimer *mPrevious;
+};
+
+// The innermost span of the calling thread, null outside of any
+const ScopedTimer *currentProfileScope();
+
+// Slow path for counters whose name is only known at runtime
+void addToProfileCounter(const std::string &name, int64_t n);
+
+#define ADVENT_PROFILE_CONCAT_INNER(a, b) a##b
+#define ADVENT_PROFILE_CONCAT(a, b) ADVENT_PROFILE_CONCAT_INNER(a, b)
+
+#define ADVENT_PROFILE_SCOPE(name)                                             \
+  ScopedTimer ADVENT_PROFILE_CONCAT(scopedTimer, __LINE__) { name }
+
+#define ADVENT_PROFILE_COUNT(name, n)                                          \
+  do {                                                                         \
+    static ProfileCounter profileCounter{name};                                \
+    profileCounter.add(n);                                                     \
+  } while (false)
+
+#define ADVENT_PROFILE_COUNT_DYNAMIC(name, n) addToProfileCounter(name, n)
+
+#define ADVENT_PROFILE_CURRENT_SCOPE() currentProfileScope()
+
+#define ADVENT_PROFILE_ADOPT_SCOPE(parent)                                     \
+  AdoptedProfileScope ADVENT_PROFILE_CONCAT(adoptedScope, __LINE__) { parent }
+
+#else
+
+// Only ever handled through pointers, which are null
+class ScopedTimer;
+
+#define ADVENT_PROFILE_SCOPE(name) static_cast<void>(name)
+#define ADVENT_PROFILE_COUNT(name, n) static_cast<void>(0)
+#define ADVENT_PROFILE_COUNT_DYNAMIC(name, n) static_cast<void>(0)
+#define ADVENT_PROFILE_CURRENT_SCOPE() static_cast<const ScopedTimer *>(nullptr)
+#define ADVENT_PROFILE_ADOPT_SCOPE(parent) static_cast<void>(parent)
+
+#endif
@@ -0,0 +1,66 @@
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "profiling.h"
+#include "radix_sort.h"
+
+namespace {
+
+// Flipping the sign bit orders the signed values as unsigned keys
+constexpr uint64_t SIGN_BIT{uint64_t{1} << 63};
+
+uint64_t sortKey(const int64_t value) {
+  return static_cast<uint64_t>(value) ^ SIGN_BIT;
+}
+
+} // namespace
+
+void radixSort(std::vector<int64_t> &values, std::vector<int64_t> &scratch) {
+  /**
+   * The bits that differ between any two values are found in one pass up
+   * front, and only the digits holding some of them get a counting pass.
+   **/
+  ADVENT_PROFILE_SCOPE("radixSort");
+  constexpr int32_t nBuckets{1 << RADIX_DIGIT_BITS};
+  constexpr uint64_t digitMask{nBuckets - 1};
+
+  if (values.size() < 2) {
+    return;
+  }
+
+  uint64_t allOnes{~uint64_t{0}};
+  uint64_t anyOnes{0};
+  for (const int64_t value : values) {
+    allOnes &= sortKey(value);
+    anyOnes |= sortKey(value);
+  }
+  const uint64_t varyingBits{allOnes ^ anyOnes};
+
+  scratch.resize(values.size());
+  std::array<int64_t, nBuckets> offsets;
+
+  for (int32_t shift{0}; shift < 64; shift += RADIX_DIGIT_BITS) {
+    if (((varyingBits >> shift) & digitMask) == 0) {
+      continue;
+    }
+    ADVENT_PROFILE_COUNT("radixSort.passes", 1);
+
+    offsets.fill(0);
+    for (const int64_t value : values) {
+      offsets[(sortKey(value) >> shift) & digitMask]++;
+    }
+
+    int64_t offset{0};
+    for (int64_t &bucket : offsets) {
+      offset += std::exchange(bucket, offset);
+    }
+
+    // Stable, so the order of the lower digits survives
+    for (const int64_t value : values) {
+      scratch[offsets[(sortKey(value) >> shift) & digitMask]++] = value;
+    }
+    values.swap(scratch);
+  }
+}
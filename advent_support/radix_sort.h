@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Bits per digit of `radixSort`: a 2048 entry histogram stays in L1
+constexpr int32_t RADIX_DIGIT_BITS{11};
+
+// Sort `values` ascending, least significant digit first. The digits every
+// value shares are skipped, so values spanning 33 bits take three passes.
+// `scratch` is the second buffer of the passes, and can be reused across
+// calls to save the allocation
+void radixSort(std::vector<int64_t> &values, std::vector<int64_t> &scratch);
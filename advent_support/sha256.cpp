@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "sha256.h"
+
+namespace {
+
+// The bytes of a block, and of the message length ending the last one
+constexpr size_t BLOCK_SIZE{64};
+constexpr size_t LENGTH_SIZE{8};
+
+constexpr std::array<uint32_t, 64> ROUND_CONSTANTS{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+uint32_t loadBigEndian(const unsigned char *bytes) {
+  return static_cast<uint32_t>(bytes[0]) << 24 |
+         static_cast<uint32_t>(bytes[1]) << 16 |
+         static_cast<uint32_t>(bytes[2]) << 8 | static_cast<uint32_t>(bytes[3]);
+}
+
+void compress(std::array<uint32_t, 8> &state, const unsigned char *block) {
+  std::array<uint32_t, 64> schedule;
+  for (size_t i{0}; i < 16; i++) {
+    schedule[i] = loadBigEndian(block + 4 * i);
+  }
+  for (size_t i{16}; i < 64; i++) {
+    const uint32_t s0{std::rotr(schedule[i - 15], 7) ^
+                      std::rotr(schedule[i - 15], 18) ^ schedule[i - 15] >> 3};
+    const uint32_t s1{std::rotr(schedule[i - 2], 17) ^
+                      std::rotr(schedule[i - 2], 19) ^ schedule[i - 2] >> 10};
+    schedule[i] = schedule[i - 16] + s0 + schedule[i - 7] + s1;
+  }
+
+  auto [a, b, c, d, e, f, g, h]{state};
+  for (size_t i{0}; i < 64; i++) {
+    const uint32_t s1{std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)};
+    const uint32_t choice{(e & f) ^ (~e & g)};
+    const uint32_t t1{h + s1 + choice + ROUND_CONSTANTS[i] + schedule[i]};
+    const uint32_t s0{std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)};
+    const uint32_t majority{(a & b) ^ (a & c) ^ (b & c)};
+    const uint32_t t2{s0 + majority};
+
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  const std::array<uint32_t, 8> rounds{a, b, c, d, e, f, g, h};
+  for (size_t i{0}; i < 8; i++) {
+    state[i] += rounds[i];
+  }
+}
+
+} // namespace
+
+std::string sha256(std::string_view data) {
+  /**
+   * FIPS 180-4: the message is padded with a one bit, zeroes and its length
+   * in bits to a whole number of blocks, each mixed into the state in turn.
+   **/
+  std::array<uint32_t, 8> state{0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                0x1f83d9ab, 0x5be0cd19};
+  const uint64_t nBits{static_cast<uint64_t>(data.size()) * 8};
+
+  while (data.size() >= BLOCK_SIZE) {
+    compress(state, reinterpret_cast<const unsigned char *>(data.data()));
+    data.remove_prefix(BLOCK_SIZE);
+  }
+
+  // The last bytes and the padding take one block, or two when the length
+  // does not fit after them
+  std::array<unsigned char, 2 * BLOCK_SIZE> tail{};
+  std::copy(data.begin(), data.end(), tail.begin());
+  tail[data.size()] = 0x80;
+  const size_t tailSize{data.size() + 1 + LENGTH_SIZE <= BLOCK_SIZE
+                            ? BLOCK_SIZE
+                            : 2 * BLOCK_SIZE};
+  for (size_t i{0}; i < LENGTH_SIZE; i++) {
+    tail[tailSize - 1 - i] = static_cast<unsigned char>(nBits >> (8 * i));
+  }
+  for (size_t offset{0}; offset < tailSize; offset += BLOCK_SIZE) {
+    compress(state, tail.data() + offset);
+  }
+
+  constexpr char HEX_DIGITS[]{"0123456789abcdef"};
+  std::string retDigest;
+  retDigest.reserve(2 * sizeof(state));
+  for (const uint32_t word : state) {
+    for (int32_t shift{28}; shift >= 0; shift -= 4) {
+      retDigest.push_back(HEX_DIGITS[(word >> shift) & 0xf]);
+    }
+  }
+
+  return retDigest;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// The SHA-256 digest of `data`, as 64 lowercase hexadecimal digits
+std::string sha256(std::string_view data);
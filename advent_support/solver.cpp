@@ -0,0 +1,39 @@
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "solver.h"
+
+namespace {
+
+std::map<std::string, Solver> &solverRegistry() {
+  // Function-local so that it is constructed before any registration runs
+  static std::map<std::string, Solver> registry;
+  return registry;
+}
+
+} // namespace
+
+void Solver::solve(const std::string &filename, std::ostream &out) const {
+  if (bothParts != nullptr) {
+    bothParts(filename, out);
+    return;
+  }
+
+  partA(filename, out);
+  partB(filename, out);
+}
+
+SolverRegistration::SolverRegistration(const std::string &day,
+                                       SolverPart partA, SolverPart partB,
+                                       SolverPart bothParts) {
+  if (!solverRegistry()
+           .emplace(day, Solver{partA, partB, bothParts})
+           .second) {
+    throw std::logic_error("Solver registered twice: " + day);
+  }
+}
+
+const std::map<std::string, Solver> &registeredSolvers() {
+  return solverRegistry();
+}
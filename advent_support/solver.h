@@ -0,0 +1,34 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+
+// Common interface of the per-day solvers, so that the multi-day runner can
+// drive all of them from a single binary
+
+using SolverPart = void (*)(const std::string &filename, std::ostream &out);
+
+struct Solver {
+  SolverPart partA;
+  SolverPart partB;
+
+  // Both parts at once, for the days whose parts share their parse. Null
+  // runs `partA` and then `partB`
+  SolverPart bothParts;
+
+  void solve(const std::string &filename, std::ostream &out) const;
+};
+
+class SolverRegistration {
+  /**
+   * Registers a day's solver on construction. Each day defines one of these
+   * at namespace scope.
+   **/
+public:
+  SolverRegistration(const std::string &day, SolverPart partA,
+                     SolverPart partB, SolverPart bothParts = nullptr);
+};
+
+// All of the registered solvers, keyed by day name (e.g. `day1`)
+const std::map<std::string, Solver> &registeredSolvers();
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int32_t nThreads) {
+  if (nThreads <= 0) {
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  mWorkers.reserve(nThreads);
+  for (int32_t i{0}; i < nThreads; i++) {
+    mWorkers.emplace_back([this]() { workerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{mMutex};
+    mStopping = true;
+  }
+  mTaskAvailable.notify_all();
+
+  // The workers drain the remaining tasks before exiting
+  for (std::thread &worker : mWorkers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::workerLoop() {
+  while (true) {
+    std::function<void()> task;
+
+    {
+      std::unique_lock<std::mutex> lock{mMutex};
+      mTaskAvailable.wait(lock,
+                          [this]() { return mStopping || !mTasks.empty(); });
+
+      if (mTasks.empty()) {
+        // Only reachable when `mStopping`
+        return;
+      }
+
+      task = std::move(mTasks.front());
+      mTasks.pop();
+    }
+
+    task();
+  }
+}
+
+std::optional<int32_t> parseThreadCount(std::string_view value) {
+  int32_t retCount{0};
+  const auto [end, error]{
+      std::from_chars(value.data(), value.data() + value.size(), retCount)};
+  if (error != std::errc{} || end != value.data() + value.size() ||
+      retCount <= 0) {
+    return std::nullopt;
+  }
+
+  return retCount;
+}
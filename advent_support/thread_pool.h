@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class ThreadPool {
+  /**
+   * A fixed-size pool of worker threads consuming a FIFO of tasks.
+   **/
+public:
+  // `nThreads == 0` uses one thread per hardware thread
+  explicit ThreadPool(int32_t nThreads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int32_t size() const { return static_cast<int32_t>(mWorkers.size()); }
+
+  template <typename F> auto submit(F &&task) {
+    using Result = std::invoke_result_t<F>;
+
+    // `std::function` requires a copyable callable, so the
+    // `std::packaged_task` lives behind a `shared_ptr`
+    auto packagedTask{
+        std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task))};
+    std::future<Result> retFuture{packagedTask->get_future()};
+
+    {
+      std::lock_guard<std::mutex> lock{mMutex};
+      mTasks.emplace([packagedTask]() { (*packagedTask)(); });
+    }
+    mTaskAvailable.notify_one();
+
+    return retFuture;
+  }
+
+private:
+  void workerLoop();
+
+  std::vector<std::thread> mWorkers{};
+  std::queue<std::function<void()>> mTasks{};
+  std::mutex mMutex{};
+  std::condition_variable mTaskAvailable{};
+  bool mStopping{false};
+};
+
+// The value of a `-j <threads>` option: a positive thread count, or
+// `std::nullopt` for anything else
+std::optional<int32_t> parseThreadCount(std::string_view value);
@@ -0,0 +1,64 @@
+#!/usr/bin/env bash
+#
+# Times every build profile of each given day on its benchmark input and
+# prints the speedup over the debug build. Run from the repository root,
+# after `make report` (or the individual profile builds) has run.
+#
+# Usage: bench/report.sh day1 day2 ...
+
+set -euo pipefail
+
+PROFILES=(debug release native lto pgo)
+RUNS=${RUNS:-3}
+
+binaryFor() {
+  local day=$1 profile=$2
+  if [[ $profile == debug ]]; then
+    echo "$day/$day"
+  else
+    echo "$day/build/$profile/$day"
+  fi
+}
+
+# Best-of-`RUNS` wall time in milliseconds
+timeBinary() {
+  local binary=$1 input=$2 best=""
+  for ((run = 0; run < RUNS; run++)); do
+    local start end elapsed
+    start=$(date +%s%N)
+    "$binary" "$input" > /dev/null
+    end=$(date +%s%N)
+    elapsed=$(((end - start) / 1000000))
+    if [[ -z $best || $elapsed -lt $best ]]; then
+      best=$elapsed
+    fi
+  done
+  echo "$best"
+}
+
+printf "%-6s %-8s %10s %9s\n" day profile "time ms" speedup
+for day in "$@"; do
+  input="bench/inputs/$day.txt"
+  debugMs=""
+
+  for profile in "${PROFILES[@]}"; do
+    binary=$(binaryFor "$day" "$profile")
+    if [[ ! -x $binary ]]; then
+      printf "%-6s %-8s %10s %9s\n" "$day" "$profile" "-" "not built"
+      continue
+    fi
+
+    ms=$(timeBinary "$binary" "$input")
+    if [[ $profile == debug ]]; then
+      debugMs=$ms
+    fi
+
+    if [[ -n $debugMs ]]; then
+      speedup=$(awk -v d="$debugMs" -v t="$ms" \
+        'BEGIN { printf "%.2fx", d / (t > 0 ? t : 1) }')
+    else
+      speedup="-"
+    fi
+    printf "%-6s %-8s %10s %9s\n" "$day" "$profile" "$ms" "$speedup"
+  done
+done
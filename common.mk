@@ -0,0 +1,133 @@
+# Shared build rules for the per-day Makefiles. Each `dayN/Makefile` includes
+# this file, and the binary is named after its directory.
+#
+# `make BUILD=<profile>` selects the build profile:
+#   debug    -g, no optimization (default). The binary is `./dayN`
+#   release  -O3 -DNDEBUG
+#   native   release + -march=native
+#   lto      native + link-time optimization, so `advent_support` gets inlined
+#   pgo      lto + profile-guided optimization, see the `pgo` target below
+# Every profile other than `debug` builds into `build/<profile>/dayN`.
+
+CXX = clang++
+CXXFLAGS = -I.. -Wall -Wextra -Wstrict-aliasing -std=c++2a -Weffc++ -pthread
+# zlib for gzip inputs, `dlopen` for libzstd, see `advent_support/decompress.h`
+LDFLAGS = -lz -ldl
+
+BUILD ?= debug
+
+ifneq ($(findstring clang,$(shell $(CXX) --version)),)
+COMPILER = clang
+else
+COMPILER = gcc
+endif
+
+RELEASE_FLAGS = -O3 -DNDEBUG
+NATIVE_FLAGS = $(RELEASE_FLAGS) -march=native
+ifeq ($(COMPILER),clang)
+LTO_FLAGS = $(NATIVE_FLAGS) -flto=thin
+else
+LTO_FLAGS = $(NATIVE_FLAGS) -flto=auto
+endif
+
+# The instrumented (`pgo-gen`) and optimized (`pgo`) builds share a build
+# directory, since GCC keys its profiles on the object file paths
+PGO_DIR = $(abspath build/pgo/profile)
+PGO_DATA = $(PGO_DIR)/default.profdata
+ifeq ($(COMPILER),clang)
+PGO_GEN_FLAGS = -fprofile-instr-generate
+PGO_USE_FLAGS = -fprofile-instr-use=$(PGO_DATA)
+else
+PGO_GEN_FLAGS = -fprofile-generate=$(PGO_DIR) -fprofile-update=single
+PGO_USE_FLAGS = -fprofile-use=$(PGO_DIR) -Wno-missing-profile
+endif
+
+ifeq ($(BUILD),debug)
+CXXFLAGS += -g
+BUILD_DIR = build/debug
+else ifeq ($(BUILD),release)
+CXXFLAGS += $(RELEASE_FLAGS)
+else ifeq ($(BUILD),native)
+CXXFLAGS += $(NATIVE_FLAGS)
+else ifeq ($(BUILD),lto)
+CXXFLAGS += $(LTO_FLAGS)
+else ifeq ($(BUILD),pgo-gen)
+CXXFLAGS += $(LTO_FLAGS) $(PGO_GEN_FLAGS)
+BUILD_DIR = build/pgo
+else ifeq ($(BUILD),pgo)
+CXXFLAGS += $(LTO_FLAGS) $(PGO_USE_FLAGS)
+else
+$(error Unknown BUILD profile: $(BUILD))
+endif
+
+# `make PROFILE=1` enables the scoped timers and counters in
+# `advent_support/profiling.h`, `make PROFILE=rdtsc` uses the `rdtsc` clock and
+# `make PROFILE=alloc` also tracks the allocations of every span
+ifdef PROFILE
+CXXFLAGS += -DADVENT_PROFILE
+ifeq ($(PROFILE),rdtsc)
+CXXFLAGS += -DADVENT_PROFILE_RDTSC
+endif
+ifeq ($(PROFILE),alloc)
+CXXFLAGS += -DADVENT_PROFILE_ALLOC
+endif
+endif
+
+BUILD_DIR ?= build/$(BUILD)
+ifdef PROFILE
+BUILD_DIR := $(BUILD_DIR)-profile-$(PROFILE)
+endif
+
+# Target binary name is the same as the parent directory
+TARGET = $(notdir $(patsubst %/,%,$(CURDIR)))
+
+ifeq ($(BUILD)$(PROFILE),debug)
+BINARY = $(TARGET)
+else
+BINARY = $(BUILD_DIR)/$(TARGET)
+endif
+
+SRC_FILES ?= $(wildcard *.cpp)
+SRC_FILES_SUPPORT = $(wildcard ../advent_support/*.cpp)
+
+# Sources from sibling directories (`../foo/bar.cpp`) build into
+# `$(BUILD_DIR)/foo/bar.o`
+OBJ_FILES = $(addprefix $(BUILD_DIR)/,$(patsubst ../%,%,$(SRC_FILES:.cpp=.o)))
+OBJ_FILES_SUPPORT = \
+	$(addprefix $(BUILD_DIR)/,$(patsubst ../%,%,$(SRC_FILES_SUPPORT:.cpp=.o)))
+
+$(BINARY): $(OBJ_FILES) $(OBJ_FILES_SUPPORT)
+	@mkdir -p $(dir $@)
+	$(CXX) $(CXXFLAGS) -o $@ $^ $(LDFLAGS)
+
+$(BUILD_DIR)/%.o: %.cpp
+	@mkdir -p $(dir $@)
+	$(CXX) $(CXXFLAGS) -MMD -MP -c -o $@ $<
+
+$(BUILD_DIR)/%.o: ../%.cpp
+	@mkdir -p $(dir $@)
+	$(CXX) $(CXXFLAGS) -MMD -MP -c -o $@ $<
+
+-include $(OBJ_FILES:.o=.d) $(OBJ_FILES_SUPPORT:.o=.d)
+
+# Build an instrumented binary, train it on `PGO_TRAINING_INPUT`, then rebuild
+# with the collected profile. The training input defaults to the benchmark
+# input from the top-level `make bench-inputs`
+PGO_TRAINING_INPUT ?= ../bench/inputs/$(TARGET).txt
+
+pgo:
+	rm -rf build/pgo
+	$(MAKE) BUILD=pgo-gen
+	LLVM_PROFILE_FILE=$(PGO_DIR)/%p.profraw \
+		build/pgo/$(TARGET) $(PGO_TRAINING_INPUT) > /dev/null
+ifeq ($(COMPILER),clang)
+	llvm-profdata merge -o $(PGO_DATA) $(PGO_DIR)/*.profraw
+endif
+	find build/pgo -name '*.o' -delete
+	rm -f build/pgo/$(TARGET)
+	$(MAKE) BUILD=pgo
+
+clean:
+	rm -rf build $(TARGET)
+
+.PHONY: pgo clean
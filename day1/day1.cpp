@@ -1,112 +1,158 @@
-#include <cctype>
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <iostream>
-#include <map>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "advent_support/cpu_dispatch.h"
 #include "advent_support/fileio.h"
-
-template <typename T> char firstNumber(T it, const T end) {
-  for (; it != end; it++) {
-    char c{*it};
-    if (isdigit(c)) {
-      return c;
-    }
+#include "advent_support/incremental.h"
+#include "advent_support/pipeline.h"
+#include "advent_support/profiling.h"
+#include "advent_support/solver.h"
+
+namespace day1 {
+
+int32_t calibrationValueA(const std::string &line) {
+  // Found by the vectorized kernel the CPU supports best
+  const DigitBounds bounds{findDigitBounds(line.data(), line.size())};
+  if (bounds.first < 0) {
+    throw std::runtime_error("No first digit found!");
   }
 
-  throw std::runtime_error("No first digit found!");
+  return (line[bounds.first] - '0') * 10 + (line[bounds.last] - '0');
 }
 
-void partA(const std::string &filename) {
-  std::vector<std::string> lines{readFileAsLines(filename)};
+void partA(const std::string &filename, std::ostream &out) {
+  ADVENT_PROFILE_SCOPE("partA");
 
+  // Lines are scanned on the pipeline's threads while the rest of the file
+  // is still being read
   int32_t calibration_value{0};
-  for (const auto &line : lines) {
-    const char firstChar{firstNumber(line.cbegin(), line.cend())};
-    const char lastChar{firstNumber(line.crbegin(), line.crend())};
-
-    const std::string number{firstChar, lastChar};
-
-    calibration_value += std::stoi(number);
-  }
-
-  std::cout << "Part A: The calibration value is: " << calibration_value
-            << std::endl;
+  runLinePipeline(
+      filename,
+      [](const std::string &line) {
+        ADVENT_PROFILE_COUNT("day1.linesScanned", 1);
+        return calibrationValueA(line);
+      },
+      [&calibration_value](int64_t, const int32_t value) {
+        calibration_value += value;
+      });
+
+  out << "Part A: The calibration value is: " << calibration_value << std::endl;
 }
 
-template <typename T> bool lookFor(T it, const T end, std::string_view target) {
-  for (std::string_view::iterator target_it = target.begin();
-       target_it != target.end(); target_it++, it++) {
-    // We ran into the end of `it` before exhausting `target`, must be `false`
-    if (it == end) {
-      return false;
-    } else if (*it != *target_it) {
-      // The strings differ
-      return false;
+int64_t calibrationSumB(const std::string *lines, const int64_t nLines) {
+  /**
+   * The part B calibration values of `nLines` lines, summed. The lines go to
+   * the vectorized kernel in batches, which finds the first and the last
+   * digit of every line of a batch at once.
+   **/
+  std::array<std::string_view, SPELLED_DIGIT_BATCH> batch;
+  std::array<int8_t, SPELLED_DIGIT_BATCH> firstDigits;
+  std::array<int8_t, SPELLED_DIGIT_BATCH> lastDigits;
+
+  int64_t retSum{0};
+  for (int64_t begin{0}; begin < nLines; begin += SPELLED_DIGIT_BATCH) {
+    const int32_t nBatchLines{static_cast<int32_t>(
+        std::min<int64_t>(SPELLED_DIGIT_BATCH, nLines - begin))};
+    std::copy(lines + begin, lines + begin + nBatchLines, batch.begin());
+    findSpelledDigits(batch.data(), nBatchLines, firstDigits.data(),
+                      lastDigits.data());
+
+    for (int32_t i{0}; i < nBatchLines; i++) {
+      if (firstDigits[i] < 0) {
+        throw std::runtime_error("No first digit found!");
+      }
+      retSum += firstDigits[i] * 10 + lastDigits[i];
     }
   }
 
-  // Everything matches up
-  return true;
+  ADVENT_PROFILE_COUNT("day1.linesScanned", nLines);
+  return retSum;
 }
 
-template <typename T>
-int32_t firstNumberWithWords(T it, const T end, bool reverse) {
-  const std::map<std::string_view, int32_t> digitMap{
-      {!reverse ? "one" : "eno", 1},     {!reverse ? "two" : "owt", 2},
-      {!reverse ? "three" : "eerht", 3}, {!reverse ? "four" : "ruof", 4},
-      {!reverse ? "five" : "evif", 5},   {!reverse ? "six" : "xis", 6},
-      {!reverse ? "seven" : "neves", 7}, {!reverse ? "eight" : "thgie", 8},
-      {!reverse ? "nine" : "enin", 9},
-  };
-
-  for (; it != end; it++) {
-    // First check for a simple digit
-    if (isdigit(*it)) {
-      // Convert the char to its int representation
-      return *it - '0';
-    }
+void partB(const std::string &filename, std::ostream &out) {
+  ADVENT_PROFILE_SCOPE("partB");
 
-    // Try each of the digits in `digitMap`
-    for (const auto &pair : digitMap) {
-      if (lookFor(it, end, pair.first)) {
-        return pair.second;
-      }
-    }
-  }
-
-  throw std::runtime_error("No first digit found!");
+  // Batches of lines are scanned on the pipeline's threads while the rest of
+  // the file is still being read. The sum wraps around like the `int32_t`
+  // counter always did
+  int32_t calibration_value{0};
+  runLineBatchPipeline(
+      filename,
+      [](const std::vector<std::string> &lines) {
+        return calibrationSumB(lines.data(), lines.size());
+      },
+      [&calibration_value](int64_t, const int64_t sum) {
+        calibration_value += static_cast<int32_t>(sum);
+      });
+
+  out << "Part B: The calibration value is: " << calibration_value << std::endl;
 }
 
-void partB(const std::string &filename) {
+void solveIncremental(const std::string &filename, std::ostream &out) {
+  /**
+   * Solve both parts, only re-solving the blocks of `filename` that changed
+   * since the previous incremental run.
+   **/
+  ADVENT_PROFILE_SCOPE("solveIncremental");
   std::vector<std::string> lines{readFileAsLines(filename)};
 
-  int32_t calibration_value{0};
-  for (const auto &line : lines) {
-    const int32_t firstDigit{
-        firstNumberWithWords(line.cbegin(), line.cend(), false)};
-    const int32_t lastDigit{
-        firstNumberWithWords(line.crbegin(), line.crend(), true)};
-    calibration_value += firstDigit * 10 + lastDigit;
+  // Each block's values are its (part A, part B) calibration sums
+  BlockCache cache{filename, "day1", 2};
+  cache.refresh(lines, [&lines](int64_t begin, int64_t end) {
+    std::vector<int64_t> sums{
+        0, calibrationSumB(lines.data() + begin, end - begin)};
+    for (int64_t i{begin}; i < end; i++) {
+      sums[0] += calibrationValueA(lines[i]);
+    }
+    return sums;
+  });
+  cache.save();
+
+  int32_t calibrationValueSumA{0};
+  int32_t calibrationValueSumB{0};
+  for (int64_t block{0}; block < cache.nBlocks(); block++) {
+    calibrationValueSumA += cache.values(block)[0];
+    calibrationValueSumB += cache.values(block)[1];
   }
 
-  std::cout << "Part B: The calibration value is: " << calibration_value
-            << std::endl;
+  out << "Part A: The calibration value is: " << calibrationValueSumA
+      << std::endl;
+  out << "Part B: The calibration value is: " << calibrationValueSumB
+      << std::endl;
 }
 
+// Register this day with the multi-day runner
+const SolverRegistration registration{"day1", partA, partB};
+
+} // namespace day1
+
+// The multi-day runner links every day together and provides its own `main`
+#ifndef ADVENT_RUNNER
 int32_t main(int argc, char *argv[]) {
+  // `--incremental` reuses the partial results cached by the previous run
+  const bool incremental{argc == 3 && std::string{argv[1]} == "--incremental"};
+
   // Check that the filename is provided
-  if (argc != 2) {
-    std::cerr << "Usage: " << argv[0] << " <filename>" << std::endl;
+  if (argc != 2 && !incremental) {
+    std::cerr << "Usage: " << argv[0] << " [--incremental] <filename>"
+              << std::endl;
     return 1;
   }
 
   try {
-    partA(argv[1]);
-    partB(argv[1]);
+    if (incremental) {
+      day1::solveIncremental(argv[2], std::cout);
+      return 0;
+    }
+
+    day1::partA(argv[1], std::cout);
+    day1::partB(argv[1], std::cout);
   } catch (const std::exception &exception) {
     std::cerr << exception.what() << std::endl;
     return 1;
@@ -114,3 +160,4 @@ int32_t main(int argc, char *argv[]) {
 
   return 0;
 }
+#endif
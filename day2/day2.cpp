@@ -1,160 +1,262 @@
-#include <cassert>
+#include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <cstdint>
 #include <iostream>
-#include <map>
-#include <regex>
+#include <sstream>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
 
 #include "advent_support/fileio.h"
+#include "advent_support/incremental.h"
+#include "advent_support/pipeline.h"
+#include "advent_support/profiling.h"
+#include "advent_support/solver.h"
+#include "game_store.h"
 
-std::string parseGamesLine(const std::string &line) {
-  // Remove the `Game` portion of each line
-  const std::regex lineRegex{"Game \\d+:(.*)"};
+namespace day2 {
 
-  std::smatch matches;
-  if (std::regex_match(line, matches, lineRegex)) {
-    assert(matches.size() == 2 && "Unexpected number of matches");
+// The bag of part A
+const BagLimits PART_A_LIMITS{12, 13, 14};
 
-    // Move semantics makes this OK to do
-    return matches[1];
-  }
-
-  throw std::runtime_error("Malformed input line: " + line);
-}
-
-std::string
-parseSingleGame(const std::string &gamesLine,
-                std::map<const std::string, int32_t> &retMarblesMap) {
+BagLimits smallestBag(std::string_view line) {
   /**
-   *  Parse a single game from `gamesLine`. Returns the
-   *  unconsumed portion of the string for further processing.
+   * The largest count of each color over the games of
+   * `Game <id>: <count> <color>, ...; ...`, which is the smallest bag they
+   * are all possible with. The line is parsed in place, so a record does not
+   * allocate. Colors other than red, green and blue are ignored.
    **/
+  auto malformed{[line]() {
+    return std::runtime_error("Malformed input line: " + std::string{line});
+  }};
+
+  const char *it{line.data()};
+  const char *const end{line.data() + line.size()};
+  auto skipSpaces{[&it, end]() {
+    while (it != end && *it == ' ') {
+      it++;
+    }
+  }};
+  auto parseNumber{[&it, end, &malformed]() {
+    int32_t value{};
+    const auto [ptr, ec]{std::from_chars(it, end, value)};
+    if (ec != std::errc{}) {
+      throw malformed();
+    }
+    it = ptr;
+    return value;
+  }};
 
-  // The *? is a lazy matching, attempting to match as few occurrences as
-  // possible
-  const std::regex gameRegex{"\\s*(.*?)(?:;|$)"};
-
-  std::smatch matches;
-  if (std::regex_search(gamesLine.cbegin(), gamesLine.cend(), matches,
-                        gameRegex)) {
-    assert(matches.size() == 2 && "Unexpected number of matches");
-
-    const std::string game{matches[1]};
-
-    const std::regex marbleRegex{"(\\d+)\\s(\\w+)(?:, )?"};
-    std::smatch marbleMatches;
-
-    std::string::const_iterator substring_cbegin{game.cbegin()};
-    const std::string::const_iterator substring_cend{game.cend()};
-
-    // Iterate each of the marble counts in `game`
-    while (std::regex_search(substring_cbegin, substring_cend, marbleMatches,
-                             marbleRegex)) {
-      assert(marbleMatches.size() == 3 && "Unexpected number of matches");
+  // Consume the `Game <id>:` header
+  if (!line.starts_with("Game ")) {
+    throw malformed();
+  }
+  it += 5;
+  parseNumber();
+  if (it == end || *it != ':') {
+    throw malformed();
+  }
+  it++;
 
-      // Extract the matched grouping
-      const int32_t count{std::stoi(marbleMatches[1])};
-      const std::string marbleType{marbleMatches[2]};
+  BagLimits retBag{0, 0, 0};
+  for (skipSpaces(); it != end; skipSpaces()) {
+    const int32_t count{parseNumber()};
+    if (it == end || *it != ' ') {
+      throw malformed();
+    }
+    it++;
 
-      // Check if `marbleType` is already in `retMarblesMap`
-      auto marbleIt{retMarblesMap.find(marbleType)};
+    const char *const colorBegin{it};
+    while (it != end && std::isalpha(static_cast<unsigned char>(*it))) {
+      it++;
+    }
+    const std::string_view color{colorBegin,
+                                 static_cast<size_t>(it - colorBegin)};
+    if (color == "red") {
+      retBag.red = std::max(retBag.red, count);
+    } else if (color == "green") {
+      retBag.green = std::max(retBag.green, count);
+    } else if (color == "blue") {
+      retBag.blue = std::max(retBag.blue, count);
+    } else if (color.empty()) {
+      throw malformed();
+    }
 
-      // The `marbleType` does not exist, simply insert
-      if (marbleIt == retMarblesMap.end()) {
-        retMarblesMap.insert(std::make_pair(marbleType, count));
-      } else {
-        // The `marbleType` does exist, insert the max of the respective `count`
-        // value
-        marbleIt->second = std::max(marbleIt->second, count);
+    // Counts are separated by `,` within a game, and games by `;`
+    skipSpaces();
+    if (it != end) {
+      if (*it != ',' && *it != ';') {
+        throw malformed();
       }
-
-      // Move the search substring forward
-      substring_cbegin = marbleMatches.suffix().first;
+      it++;
     }
-
-    // Return the unconsumed portion of the `gamesLine`. Move semantics makes
-    // this OK to do
-    return matches.suffix();
   }
 
-  throw std::runtime_error("Malformed games line: " + gamesLine);
+  return retBag;
 }
 
-bool isGamePossible(std::map<const std::string, int32_t> &marblesMap) {
-  auto redIt{marblesMap.find("red")};
-  auto greenIt{marblesMap.find("green")};
-  auto blueIt{marblesMap.find("blue")};
+void addGame(const std::string &line, const int64_t id, GameStore &retStore) {
+  const BagLimits bag{smallestBag(line)};
+  retStore.addGame(id, bag.red, bag.green, bag.blue);
+}
 
-  int32_t nRed{redIt != marblesMap.end() ? redIt->second : 0};
-  int32_t nGreen{greenIt != marblesMap.end() ? greenIt->second : 0};
-  int32_t nBlue{blueIt != marblesMap.end() ? blueIt->second : 0};
+GameStore parseGames(const std::string &filename) {
+  /**
+   * Parse every game of `filename` once. The game IDs are line numbers,
+   * starting at 1.
+   **/
+  ADVENT_PROFILE_SCOPE("parseGames");
+
+  GameStore retStore;
+
+  // Games are parsed on the pipeline's threads while the rest of the file is
+  // still being read
+  runLinePipeline(
+      filename,
+      [](const std::string &line) {
+        ADVENT_PROFILE_COUNT("day2.lines", 1);
+        return smallestBag(line);
+      },
+      [&retStore](const int64_t lineIndex, const BagLimits &bag) {
+        retStore.addGame(lineIndex + 1, bag.red, bag.green, bag.blue);
+      });
+
+  return retStore;
+}
 
-  return (nRed <= 12) && (nGreen <= 13) && (nBlue <= 14);
+void printPartA(const GameStore &store, std::ostream &out) {
+  out << "Part A: The possible games sum is: "
+      << store.evaluate(PART_A_LIMITS).idsSum << std::endl;
 }
 
-void partA(const std::string &filename) {
-  std::vector<std::string> lines{readFileAsLines(filename)};
+void printPartB(const GameStore &store, std::ostream &out) {
+  out << "Part B: The powers sum is: " << store.powersSum() << std::endl;
+}
 
-  int32_t possibleGamesSum{0};
-  int32_t roundId{1};
-  for (auto &line : lines) {
-    std::map<const std::string, int32_t> marblesMap{};
+void partA(const std::string &filename, std::ostream &out) {
+  ADVENT_PROFILE_SCOPE("partA");
+  printPartA(parseGames(filename), out);
+}
 
-    // Consume `games` until it is empty, populating the `marblesMap` on each
-    // iteration
-    std::string games{parseGamesLine(line)};
-    while (!games.empty()) {
-      games = parseSingleGame(games, marblesMap);
-    }
+void partB(const std::string &filename, std::ostream &out) {
+  ADVENT_PROFILE_SCOPE("partB");
+  printPartB(parseGames(filename), out);
+}
+
+void bothParts(const std::string &filename, std::ostream &out) {
+  /**
+   * Both parts are answered from the same games, so they are parsed once.
+   **/
+  ADVENT_PROFILE_SCOPE("bothParts");
+
+  const GameStore store{parseGames(filename)};
+  printPartA(store, out);
+  printPartB(store, out);
+}
 
-    if (isGamePossible(marblesMap)) {
-      possibleGamesSum += roundId;
+void answerLimitQueries(const std::string &filename,
+                        const std::string &queriesFilename,
+                        std::ostream &out) {
+  /**
+   * Answer every `<red> <green> <blue>` line of `queriesFilename` with the
+   * sum of the IDs and the sum of the powers of the games possible with that
+   * bag, on one line.
+   **/
+  ADVENT_PROFILE_SCOPE("answerLimitQueries");
+  const GameStore store{parseGames(filename)};
+
+  std::vector<BagLimits> queries;
+  for (const std::string &line : readFileAsLines(queriesFilename)) {
+    std::istringstream lineStream{line};
+    BagLimits limits{};
+    if (!(lineStream >> limits.red >> limits.green >> limits.blue)) {
+      throw std::runtime_error("Malformed query line: " + line);
     }
+    queries.push_back(limits);
+  }
 
-    // Move on to the next round
-    roundId++;
+  std::string answers;
+  for (const LimitAnswer &answer : store.evaluateBatch(queries)) {
+    answers.append(std::to_string(answer.idsSum));
+    answers.push_back(' ');
+    answers.append(std::to_string(answer.powersSum));
+    answers.push_back('\n');
   }
 
-  std::cout << "Part A: The possible games sum is: " << possibleGamesSum
-            << std::endl;
+  out << answers;
 }
 
-void partB(const std::string &filename) {
+void solveIncremental(const std::string &filename, std::ostream &out) {
+  /**
+   * Solve both parts, only re-solving the blocks of `filename` that changed
+   * since the previous incremental run.
+   **/
+  ADVENT_PROFILE_SCOPE("solveIncremental");
   std::vector<std::string> lines{readFileAsLines(filename)};
 
-  int32_t powersSum{0};
-  for (auto &line : lines) {
-    std::map<const std::string, int32_t> marblesMap{
-        {"red", 0},
-        {"green", 0},
-        {"blue", 0},
-    };
-
-    // Consume `games` until it is empty, populating the `marblesMap` on each
-    // iteration
-    std::string games{parseGamesLine(line)};
-    while (!games.empty()) {
-      games = parseSingleGame(games, marblesMap);
+  // Each block's values are its (possible games, powers) sums. The game IDs
+  // are line numbers, which are fixed for a given block
+  BlockCache cache{filename, "day2", 2};
+  cache.refresh(lines, [&lines](int64_t begin, int64_t end) {
+    GameStore store;
+    for (int64_t i{begin}; i < end; i++) {
+      addGame(lines[i], i + 1, store);
     }
 
-    powersSum +=
-        marblesMap.at("red") * marblesMap.at("green") * marblesMap.at("blue");
+    return std::vector<int64_t>{store.evaluate(PART_A_LIMITS).idsSum,
+                                store.powersSum()};
+  });
+  cache.save();
+
+  int64_t possibleGamesSum{0};
+  int64_t powersSum{0};
+  for (int64_t block{0}; block < cache.nBlocks(); block++) {
+    possibleGamesSum += cache.values(block)[0];
+    powersSum += cache.values(block)[1];
   }
 
-  std::cout << "Part B: The powers sum is: " << powersSum << std::endl;
+  out << "Part A: The possible games sum is: " << possibleGamesSum << std::endl;
+  out << "Part B: The powers sum is: " << powersSum << std::endl;
 }
 
+// Register this day with the multi-day runner
+const SolverRegistration registration{"day2", partA, partB, bothParts};
+
+} // namespace day2
+
+// The multi-day runner links every day together and provides its own `main`
+#ifndef ADVENT_RUNNER
 int32_t main(int argc, char *argv[]) {
+  // `--incremental` reuses the partial results cached by the previous run
+  const bool incremental{argc == 3 && std::string{argv[1]} == "--incremental"};
+
+  // `day2 <input> --limits <query file>` answers bag-limit queries instead
+  const bool limits{argc == 4 && std::string{argv[2]} == "--limits"};
+
   // Check that the filename is provided
-  if (argc != 2) {
-    std::cerr << "Usage: " << argv[0] << " <filename>" << std::endl;
+  if (argc != 2 && !incremental && !limits) {
+    std::cerr << "Usage: " << argv[0] << " [--incremental] <filename>"
+              << std::endl;
+    std::cerr << "       " << argv[0] << " <filename> --limits <query file>"
+              << std::endl;
     return 1;
   }
 
   try {
-    partA(argv[1]);
-    partB(argv[1]);
+    if (incremental) {
+      day2::solveIncremental(argv[2], std::cout);
+      return 0;
+    }
+
+    if (limits) {
+      day2::answerLimitQueries(argv[1], argv[3], std::cout);
+      return 0;
+    }
+
+    day2::bothParts(argv[1], std::cout);
   } catch (const std::exception &exception) {
     std::cerr << exception.what() << std::endl;
     return 1;
@@ -162,3 +264,4 @@ int32_t main(int argc, char *argv[]) {
 
   return 0;
 }
+#endif
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "advent_support/cpu_dispatch.h"
+#include "advent_support/profiling.h"
+#include "game_store.h"
+
+namespace {
+
+std::vector<int32_t> distinctValues(std::vector<int32_t> values) {
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  return values;
+}
+
+// The number of `values` at most `limit`
+int64_t countAtMost(const std::vector<int32_t> &values, const int32_t limit) {
+  return std::upper_bound(values.cbegin(), values.cend(), limit) -
+         values.cbegin();
+}
+
+} // namespace
+
+void GameStore::addGame(const int64_t id, const int32_t red,
+                        const int32_t green, const int32_t blue) {
+  mReds.push_back(red);
+  mGreens.push_back(green);
+  mBlues.push_back(blue);
+  mIds.push_back(id);
+  mPowers.push_back(int64_t{red} * green * blue);
+}
+
+int64_t GameStore::powersSum() const {
+  return std::accumulate(mPowers.cbegin(), mPowers.cend(), int64_t{0});
+}
+
+LimitAnswer GameStore::evaluate(const BagLimits &limits) const {
+  const MaskedSums sums{sumWithinLimits(
+      mReds.data(), mGreens.data(), mBlues.data(), mIds.data(),
+      mPowers.data(), size(), limits.red, limits.green, limits.blue)};
+  return LimitAnswer{sums.first, sums.second};
+}
+
+std::vector<LimitAnswer>
+GameStore::evaluateBatch(const std::vector<BagLimits> &queries) const {
+  ADVENT_PROFILE_SCOPE("evaluateBatch");
+  std::vector<LimitAnswer> retAnswers;
+  retAnswers.reserve(queries.size());
+
+  // Building the index touches every cell once, scanning touches every game
+  // once per query
+  const int64_t nCells{DominanceIndex::nCells(*this)};
+  const int64_t scanCost{static_cast<int64_t>(queries.size()) * size()};
+  if (nCells <= DominanceIndex::MAX_CELLS && nCells < scanCost) {
+    ADVENT_PROFILE_COUNT("day2.indexedQueries", queries.size());
+    const DominanceIndex index{*this};
+    for (const BagLimits &limits : queries) {
+      retAnswers.push_back(index.evaluate(limits));
+    }
+    return retAnswers;
+  }
+
+  ADVENT_PROFILE_COUNT("day2.scannedQueries", queries.size());
+  for (const BagLimits &limits : queries) {
+    retAnswers.push_back(evaluate(limits));
+  }
+  return retAnswers;
+}
+
+int64_t DominanceIndex::nCells(const GameStore &store) {
+  // Saturates rather than overflows, anything that large is not built anyway
+  int64_t retCells{1};
+  for (const auto *column : {&store.reds(), &store.greens(), &store.blues()}) {
+    const int64_t nDistinct{
+        static_cast<int64_t>(distinctValues(*column).size()) + 1};
+    retCells = std::min(retCells * nDistinct, MAX_CELLS + 1);
+  }
+
+  return retCells;
+}
+
+DominanceIndex::DominanceIndex(const GameStore &store)
+    : mReds{distinctValues(store.reds())},
+      mGreens{distinctValues(store.greens())},
+      mBlues{distinctValues(store.blues())} {
+  ADVENT_PROFILE_SCOPE("DominanceIndex");
+  const int64_t nReds{static_cast<int64_t>(mReds.size())};
+  const int64_t nGreens{static_cast<int64_t>(mGreens.size())};
+  const int64_t nBlues{static_cast<int64_t>(mBlues.size())};
+  mPrefixSums.assign((nReds + 1) * (nGreens + 1) * (nBlues + 1),
+                     LimitAnswer{0, 0});
+
+  // Every game lands on the cell of its own counts...
+  for (int64_t i{0}; i < store.size(); i++) {
+    LimitAnswer &answer{
+        mPrefixSums[cell(countAtMost(mReds, store.reds()[i]),
+                         countAtMost(mGreens, store.greens()[i]),
+                         countAtMost(mBlues, store.blues()[i]))]};
+    answer.idsSum += store.ids()[i];
+    answer.powersSum += store.powers()[i];
+  }
+
+  // ...and then counts towards every cell dominating it, one axis at a time
+  auto addCell{[this](const int64_t to, const int64_t from) {
+    mPrefixSums[to].idsSum += mPrefixSums[from].idsSum;
+    mPrefixSums[to].powersSum += mPrefixSums[from].powersSum;
+  }};
+
+  for (int64_t red{1}; red <= nReds; red++) {
+    for (int64_t green{0}; green <= nGreens; green++) {
+      for (int64_t blue{0}; blue <= nBlues; blue++) {
+        addCell(cell(red, green, blue), cell(red - 1, green, blue));
+      }
+    }
+  }
+
+  for (int64_t red{0}; red <= nReds; red++) {
+    for (int64_t green{1}; green <= nGreens; green++) {
+      for (int64_t blue{0}; blue <= nBlues; blue++) {
+        addCell(cell(red, green, blue), cell(red, green - 1, blue));
+      }
+    }
+  }
+
+  for (int64_t red{0}; red <= nReds; red++) {
+    for (int64_t green{0}; green <= nGreens; green++) {
+      for (int64_t blue{1}; blue <= nBlues; blue++) {
+        addCell(cell(red, green, blue), cell(red, green, blue - 1));
+      }
+    }
+  }
+}
+
+LimitAnswer DominanceIndex::evaluate(const BagLimits &limits) const {
+  return mPrefixSums[cell(countAtMost(mReds, limits.red),
+                          countAtMost(mGreens, limits.green),
+                          countAtMost(mBlues, limits.blue))];
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct BagLimits {
+  int32_t red;
+  int32_t green;
+  int32_t blue;
+};
+
+// What a bag with given limits allows: the sums of the IDs and of the powers
+// of the games that are possible with it
+struct LimitAnswer {
+  int64_t idsSum;
+  int64_t powersSum;
+};
+
+class GameStore {
+  /**
+   * Every game reduced to its largest red, green and blue counts, stored as
+   * one column per field, so that a limit query is a vectorized scan over
+   * the columns instead of a re-parse of the games.
+   **/
+public:
+  void addGame(int64_t id, int32_t red, int32_t green, int32_t blue);
+
+  int64_t size() const { return static_cast<int64_t>(mIds.size()); }
+
+  const std::vector<int32_t> &reds() const { return mReds; }
+  const std::vector<int32_t> &greens() const { return mGreens; }
+  const std::vector<int32_t> &blues() const { return mBlues; }
+  const std::vector<int64_t> &ids() const { return mIds; }
+
+  // The power of a game is the product of its largest counts
+  const std::vector<int64_t> &powers() const { return mPowers; }
+
+  int64_t powersSum() const;
+
+  LimitAnswer evaluate(const BagLimits &limits) const;
+
+  // Answers in query order. Large batches are answered from a
+  // `DominanceIndex` when one fits, and by scanning otherwise
+  std::vector<LimitAnswer>
+  evaluateBatch(const std::vector<BagLimits> &queries) const;
+
+private:
+  std::vector<int32_t> mReds{};
+  std::vector<int32_t> mGreens{};
+  std::vector<int32_t> mBlues{};
+  std::vector<int64_t> mIds{};
+  std::vector<int64_t> mPowers{};
+};
+
+class DominanceIndex {
+  /**
+   * The answer to every possible limit query, precomputed: a 3-D prefix sum
+   * over the distinct red, green and blue counts of the games. A query is
+   * three binary searches, for the largest count of each color within its
+   * limit, and one lookup.
+   **/
+public:
+  // Indices larger than this are not worth building
+  static constexpr int64_t MAX_CELLS{int64_t{1} << 20};
+
+  // The number of cells an index of `store` needs
+  static int64_t nCells(const GameStore &store);
+
+  explicit DominanceIndex(const GameStore &store);
+
+  LimitAnswer evaluate(const BagLimits &limits) const;
+
+private:
+  int64_t cell(int64_t red, int64_t green, int64_t blue) const {
+    const int64_t nGreens{static_cast<int64_t>(mGreens.size())};
+    const int64_t nBlues{static_cast<int64_t>(mBlues.size())};
+    return (red * (nGreens + 1) + green) * (nBlues + 1) + blue;
+  }
+
+  // The distinct counts of each color, ascending
+  std::vector<int32_t> mReds{};
+  std::vector<int32_t> mGreens{};
+  std::vector<int32_t> mBlues{};
+
+  // Cell (r, g, b) sums the games whose counts are at most the r-th red, g-th
+  // green and b-th blue count, 1-based, so that the 0 planes are empty
+  std::vector<LimitAnswer> mPrefixSums{};
+};
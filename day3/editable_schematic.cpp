@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "advent_support/profiling.h"
+#include "editable_schematic.h"
+#include "sparse_schematic.h"
+
+EditableSchematic::EditableSchematic(std::string_view contents) {
+  ADVENT_PROFILE_SCOPE("buildEditableSchematic");
+
+  size_t rowStart{0};
+  while (rowStart < contents.size()) {
+    size_t rowEnd{contents.find('\n', rowStart)};
+    if (rowEnd == std::string_view::npos) {
+      rowEnd = contents.size();
+    }
+
+    mRows.emplace_back(contents.substr(rowStart, rowEnd - rowStart));
+    mNumberIds.emplace_back(mRows.back().size(), NO_NUMBER);
+    rowStart = rowEnd + 1;
+  }
+
+  // The sparse form finds the numbers and the gears without visiting the
+  // empty cells
+  const SparseSchematic sparse{contents};
+  for (const SchematicNumber &number : sparse.numbers()) {
+    addNumber(number.row, number.begin, number.end);
+  }
+  for (const SchematicSymbol &gear : sparse.gears()) {
+    mGearRatioSum += gearRatio(gear.row, gear.column);
+  }
+}
+
+int32_t EditableSchematic::numberAt(const int32_t row,
+                                    const int32_t column) const {
+  if (row < 0 || row >= height() || column < 0 || column >= width(row)) {
+    return NO_NUMBER;
+  }
+
+  return mNumberIds[row][column];
+}
+
+bool EditableSchematic::isSymbol(const int32_t row,
+                                 const int32_t column) const {
+  if (row < 0 || row >= height() || column < 0 || column >= width(row)) {
+    return false;
+  }
+
+  const char value{mRows[row][column]};
+  return value != '.' && !isdigit(value);
+}
+
+void EditableSchematic::addNumber(const int32_t row, const int32_t begin,
+                                  const int32_t end) {
+  Number number{row, begin, end, 0, 0};
+  for (int32_t column{begin}; column < end; column++) {
+    number.value = number.value * 10 + (mRows[row][column] - '0');
+  }
+
+  for (int32_t inspectRow{row - 1}; inspectRow <= row + 1; inspectRow++) {
+    for (int32_t column{begin - 1}; column <= end; column++) {
+      number.nSymbols += isSymbol(inspectRow, column) ? 1 : 0;
+    }
+  }
+
+  int32_t id{static_cast<int32_t>(mNumbers.size())};
+  if (mFreeIds.empty()) {
+    mNumbers.push_back(number);
+  } else {
+    id = mFreeIds.back();
+    mFreeIds.pop_back();
+    mNumbers[id] = number;
+  }
+
+  std::fill(mNumberIds[row].begin() + begin, mNumberIds[row].begin() + end,
+            id);
+  if (number.nSymbols > 0) {
+    mPartNumberSum += number.value;
+  }
+}
+
+void EditableSchematic::removeNumber(const int32_t id) {
+  const Number &number{mNumbers[id]};
+  std::fill(mNumberIds[number.row].begin() + number.begin,
+            mNumberIds[number.row].begin() + number.end, NO_NUMBER);
+  if (number.nSymbols > 0) {
+    mPartNumberSum -= number.value;
+  }
+
+  mFreeIds.push_back(id);
+}
+
+void EditableSchematic::adjustTouchingNumbers(const int32_t row,
+                                              const int32_t column,
+                                              const int32_t delta) {
+  // A number spans at most three cells of a row of the neighbourhood, so it
+  // is only counted at the first of them
+  for (int32_t inspectRow{row - 1}; inspectRow <= row + 1; inspectRow++) {
+    for (int32_t inspectColumn{column - 1}; inspectColumn <= column + 1;
+         inspectColumn++) {
+      const int32_t id{numberAt(inspectRow, inspectColumn)};
+      if (id == NO_NUMBER ||
+          (inspectColumn > column - 1 &&
+           numberAt(inspectRow, inspectColumn - 1) == id)) {
+        continue;
+      }
+
+      Number &number{mNumbers[id]};
+      const bool wasPart{number.nSymbols > 0};
+      number.nSymbols += delta;
+      const bool isPart{number.nSymbols > 0};
+
+      if (wasPart != isPart) {
+        mPartNumberSum += isPart ? number.value : -number.value;
+      }
+    }
+  }
+}
+
+int64_t EditableSchematic::gearRatio(const int32_t row,
+                                     const int32_t column) const {
+  if (mRows[row][column] != '*') {
+    return 0;
+  }
+
+  int32_t nNumbers{0};
+  int64_t ratio{1};
+  for (int32_t inspectRow{row - 1}; inspectRow <= row + 1; inspectRow++) {
+    for (int32_t inspectColumn{column - 1}; inspectColumn <= column + 1;
+         inspectColumn++) {
+      const int32_t id{numberAt(inspectRow, inspectColumn)};
+      if (id == NO_NUMBER ||
+          (inspectColumn > column - 1 &&
+           numberAt(inspectRow, inspectColumn - 1) == id)) {
+        continue;
+      }
+
+      ratio *= mNumbers[id].value;
+      nNumbers++;
+    }
+  }
+
+  return nNumbers == 2 ? ratio : 0;
+}
+
+void EditableSchematic::setCell(const int32_t row, const int32_t column,
+                                const char value) {
+  /**
+   * The numbers the edit can change are the ones covering the cell and its
+   * left and right neighbours, and the numbers after the edit only cover
+   * cells of those or the cell itself. So the gears that can change are the
+   * ones around those numbers and the cell: their ratios are taken out
+   * before the edit and put back after it.
+   **/
+  if (row < 0 || row >= height() || column < 0 || column >= width(row)) {
+    throw std::out_of_range("Cell outside the schematic: " +
+                            std::to_string(row) + " " + std::to_string(column));
+  }
+  if (value == '\n') {
+    throw std::invalid_argument("A cell cannot hold a newline");
+  }
+  ADVENT_PROFILE_COUNT("day3.cellEdits", 1);
+
+  // The columns [regionBegin, regionEnd) of `row`, widened by one cell in
+  // every direction, hold every gear the edit can change
+  int32_t regionBegin{column};
+  int32_t regionEnd{column + 1};
+  std::array<int32_t, 3> oldIds{};
+  int32_t nOldIds{0};
+  for (int32_t inspectColumn{column - 1}; inspectColumn <= column + 1;
+       inspectColumn++) {
+    const int32_t id{numberAt(row, inspectColumn)};
+    if (id != NO_NUMBER && (nOldIds == 0 || oldIds[nOldIds - 1] != id)) {
+      oldIds[nOldIds++] = id;
+      regionBegin = std::min(regionBegin, mNumbers[id].begin);
+      regionEnd = std::max(regionEnd, mNumbers[id].end);
+    }
+  }
+
+  auto regionGearRatios{[&]() {
+    int64_t retSum{0};
+    for (int32_t inspectRow{std::max(row - 1, 0)};
+         inspectRow <= std::min(row + 1, height() - 1); inspectRow++) {
+      for (int32_t inspectColumn{std::max(regionBegin - 1, 0)};
+           inspectColumn <= std::min(regionEnd, width(inspectRow) - 1);
+           inspectColumn++) {
+        retSum += gearRatio(inspectRow, inspectColumn);
+      }
+    }
+    return retSum;
+  }};
+
+  mGearRatioSum -= regionGearRatios();
+
+  for (int32_t i{0}; i < nOldIds; i++) {
+    removeNumber(oldIds[i]);
+  }
+  if (isSymbol(row, column)) {
+    adjustTouchingNumbers(row, column, -1);
+  }
+
+  mRows[row][column] = value;
+
+  if (isSymbol(row, column)) {
+    adjustTouchingNumbers(row, column, 1);
+  }
+
+  // Re-create the digit runs through the cell and its neighbours
+  for (int32_t inspectColumn{std::max(column - 1, 0)};
+       inspectColumn <= std::min(column + 1, width(row) - 1);
+       inspectColumn++) {
+    if (!isdigit(mRows[row][inspectColumn]) ||
+        mNumberIds[row][inspectColumn] != NO_NUMBER) {
+      continue;
+    }
+
+    int32_t begin{inspectColumn};
+    while (begin > 0 && isdigit(mRows[row][begin - 1])) {
+      begin--;
+    }
+    int32_t end{inspectColumn + 1};
+    while (end < width(row) && isdigit(mRows[row][end])) {
+      end++;
+    }
+    addNumber(row, begin, end);
+  }
+
+  mGearRatioSum += regionGearRatios();
+}
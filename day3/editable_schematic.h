@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class EditableSchematic {
+  /**
+   * An engine schematic that keeps the part number sum (part A) and the gear
+   * ratio sum (part B) up to date as its cells are edited.
+   *
+   * Every cell knows the number covering it, and every number knows how many
+   * symbols touch it. An edit re-creates at most the three numbers around the
+   * cell, and re-evaluates only the gears next to those numbers or to the
+   * cell, so it costs time proportional to the length of the numbers it
+   * touches rather than to the size of the grid.
+   **/
+public:
+  explicit EditableSchematic(std::string_view contents);
+
+  int32_t height() const { return static_cast<int32_t>(mRows.size()); }
+  int32_t width(int32_t row) const {
+    return static_cast<int32_t>(mRows[row].size());
+  }
+
+  char cell(int32_t row, int32_t column) const { return mRows[row][column]; }
+
+  // Replace the cell at (row, column), which must exist, with `value`
+  void setCell(int32_t row, int32_t column, char value);
+
+  // The sum of the numbers touching a symbol
+  int64_t partNumberSum() const { return mPartNumberSum; }
+
+  // The sum of the products of the two numbers touching each `*` touched by
+  // exactly two numbers
+  int64_t gearRatioSum() const { return mGearRatioSum; }
+
+private:
+  struct Number {
+    int32_t row;
+    // The number spans the columns [begin, end)
+    int32_t begin;
+    int32_t end;
+    int64_t value;
+    // The symbol cells touching the number
+    int32_t nSymbols;
+  };
+
+  static constexpr int32_t NO_NUMBER{-1};
+
+  // The number covering (row, column), or `NO_NUMBER`, including outside the
+  // schematic
+  int32_t numberAt(int32_t row, int32_t column) const;
+
+  bool isSymbol(int32_t row, int32_t column) const;
+
+  // Create the number spanning [begin, end) of `row`, from the digits there
+  void addNumber(int32_t row, int32_t begin, int32_t end);
+  void removeNumber(int32_t id);
+
+  // Add `delta` to the symbol count of every number touching (row, column)
+  void adjustTouchingNumbers(int32_t row, int32_t column, int32_t delta);
+
+  // The ratio the `*` at (row, column) contributes to `gearRatioSum()`
+  int64_t gearRatio(int32_t row, int32_t column) const;
+
+  std::vector<std::string> mRows{};
+
+  // The ID of the number covering each cell, indexing `mNumbers`
+  std::vector<std::vector<int32_t>> mNumberIds{};
+  std::vector<Number> mNumbers{};
+  std::vector<int32_t> mFreeIds{};
+
+  int64_t mPartNumberSum{0};
+  int64_t mGearRatioSum{0};
+};
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "advent_support/profiling.h"
+#include "sparse_schematic.h"
+
+namespace {
+
+std::vector<SchematicRows> parseRows(std::string_view contents) {
+  // A single run of every row
+  std::vector<SchematicRows> retRuns(1);
+
+  size_t rowStart{0};
+  while (rowStart < contents.size()) {
+    size_t rowEnd{contents.find('\n', rowStart)};
+    if (rowEnd == std::string_view::npos) {
+      rowEnd = contents.size();
+    }
+
+    retRuns.front().parseRow(contents.substr(rowStart, rowEnd - rowStart));
+    rowStart = rowEnd + 1;
+  }
+
+  return retRuns;
+}
+
+} // namespace
+
+void SchematicRows::parseRow(std::string_view rowText) {
+  const int32_t row{static_cast<int32_t>(numberRows.size()) - 1};
+
+  // Jump straight over the runs of `.`
+  size_t j{rowText.find_first_not_of('.')};
+  while (j != std::string_view::npos) {
+    if (isdigit(rowText[j])) {
+      const int32_t begin{static_cast<int32_t>(j)};
+      int32_t value{0};
+      for (; j < rowText.size() && isdigit(rowText[j]); j++) {
+        value = value * 10 + (rowText[j] - '0');
+      }
+
+      numbers.push_back({row, begin, static_cast<int32_t>(j), value});
+    } else {
+      symbols.push_back({row, static_cast<int32_t>(j), rowText[j]});
+      j++;
+    }
+
+    j = rowText.find_first_not_of('.', j);
+  }
+
+  numberRows.push_back(static_cast<int32_t>(numbers.size()));
+  symbolRows.push_back(static_cast<int32_t>(symbols.size()));
+}
+
+SparseSchematic::SparseSchematic(std::string_view contents)
+    : SparseSchematic{parseRows(contents)} {}
+
+SparseSchematic::SparseSchematic(std::vector<SchematicRows> runs) {
+  /**
+   * Concatenate the runs, shifting their rows past those of the runs before
+   * them.
+   **/
+  ADVENT_PROFILE_SCOPE("buildSparseSchematic");
+
+  for (const SchematicRows &run : runs) {
+    const int32_t firstRow{height()};
+    const int32_t firstNumber{static_cast<int32_t>(mNumbers.size())};
+    const int32_t firstSymbol{static_cast<int32_t>(mSymbols.size())};
+
+    for (SchematicNumber number : run.numbers) {
+      number.row += firstRow;
+      mNumbers.push_back(number);
+    }
+    for (SchematicSymbol symbol : run.symbols) {
+      symbol.row += firstRow;
+      mSymbols.push_back(symbol);
+      if (symbol.symbol == '*') {
+        mGears.push_back(symbol);
+      }
+    }
+
+    for (size_t i{1}; i < run.numberRows.size(); i++) {
+      mNumberRows.push_back(firstNumber + run.numberRows[i]);
+      mSymbolRows.push_back(firstSymbol + run.symbolRows[i]);
+    }
+  }
+
+  ADVENT_PROFILE_COUNT("day3.numbersParsed", mNumbers.size());
+}
+
+bool SparseSchematic::touchesSymbol(const SchematicNumber &number) const {
+  for (int32_t inspectRow{std::max(number.row - 1, 0)};
+       inspectRow <= std::min(number.row + 1, height() - 1); inspectRow++) {
+    const auto rowEnd{mSymbols.cbegin() + mSymbolRows[inspectRow + 1]};
+
+    // The first symbol at or right of the column before the number
+    const auto it{std::lower_bound(
+        mSymbols.cbegin() + mSymbolRows[inspectRow], rowEnd, number.begin - 1,
+        [](const SchematicSymbol &symbol, int32_t column) {
+          return symbol.column < column;
+        })};
+    if (it != rowEnd && it->column <= number.end) {
+      return true;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+struct SchematicNumber {
+  int32_t row;
+  // The number spans the columns [begin, end)
+  int32_t begin;
+  int32_t end;
+  int32_t value;
+};
+
+struct SchematicSymbol {
+  int32_t row;
+  int32_t column;
+  char symbol;
+};
+
+// The non-empty cells of a run of consecutive rows, which parses on its own:
+// the rows are counted from the first of the run
+struct SchematicRows {
+  std::vector<SchematicNumber> numbers{};
+  std::vector<SchematicSymbol> symbols{};
+
+  // Row `i`'s numbers are [numberRows[i], numberRows[i + 1]) of `numbers`,
+  // and likewise for the symbols
+  std::vector<int32_t> numberRows{0};
+  std::vector<int32_t> symbolRows{0};
+
+  // Append the next row of the run
+  void parseRow(std::string_view rowText);
+};
+
+class SparseSchematic {
+  /**
+   * An engine schematic stored as its non-empty cells only: the numbers and
+   * the symbols, each sorted by (row, column) and bucketed by row. Adjacency
+   * queries binary search the (at most) three rows around a cell, so they
+   * never look at the `.`s in between.
+   **/
+public:
+  // Built in a single pass over the text of the schematic
+  explicit SparseSchematic(std::string_view contents);
+
+  // Built from runs of rows parsed separately, in row order
+  explicit SparseSchematic(std::vector<SchematicRows> runs);
+
+  int32_t height() const {
+    return static_cast<int32_t>(mNumberRows.size()) - 1;
+  }
+
+  const std::vector<SchematicNumber> &numbers() const { return mNumbers; }
+
+  // The `*` symbols, in (row, column) order
+  const std::vector<SchematicSymbol> &gears() const { return mGears; }
+
+  // Whether any symbol is adjacent to `number`, diagonals included
+  bool touchesSymbol(const SchematicNumber &number) const;
+
+  // Call `visit` with every number adjacent to cell (row, column)
+  template <typename F>
+  void forEachAdjacentNumber(int32_t row, int32_t column, F &&visit) const {
+    for (int32_t inspectRow{std::max(row - 1, 0)};
+         inspectRow <= std::min(row + 1, height() - 1); inspectRow++) {
+      const auto rowEnd{mNumbers.cbegin() + mNumberRows[inspectRow + 1]};
+
+      // Numbers in a row do not overlap, so they are sorted by `end` too
+      auto it{std::lower_bound(
+          mNumbers.cbegin() + mNumberRows[inspectRow], rowEnd, column,
+          [](const SchematicNumber &number, int32_t c) {
+            return number.end < c;
+          })};
+      for (; it != rowEnd && it->begin <= column + 1; it++) {
+        visit(*it);
+      }
+    }
+  }
+
+private:
+  std::vector<SchematicNumber> mNumbers{};
+  std::vector<SchematicSymbol> mSymbols{};
+  std::vector<SchematicSymbol> mGears{};
+
+  // Row `i`'s numbers are [mNumberRows[i], mNumberRows[i + 1]) of `mNumbers`,
+  // and likewise for the symbols
+  std::vector<int32_t> mNumberRows{0};
+  std::vector<int32_t> mSymbolRows{0};
+};
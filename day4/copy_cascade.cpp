@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#include "advent_support/profiling.h"
+#include "advent_support/thread_pool.h"
+#include "copy_cascade.h"
+
+namespace {
+
+// Fewer cards per block than this are not worth a task of their own
+const int64_t MIN_BLOCK_SIZE{16 * 1024};
+
+struct BlockTransfer {
+  /**
+   * The effect of the cards [begin, end) as affine functions of the state
+   * entering the block. That state is `window` lanes holding the copies that
+   * earlier cards hand to cards [begin, begin + window), plus a constant lane
+   * that is always 1. Each function is stored as its `window + 1`
+   * coefficients.
+   **/
+  // The copies handed to cards [end, end + window), one function per card
+  std::vector<uint64_t> outgoing{};
+  // The total number of copies of the cards in the block
+  std::vector<uint64_t> total{};
+};
+
+BlockTransfer blockTransfer(const std::vector<int32_t> &nMatches,
+                            int64_t begin, int64_t end, int64_t window) {
+  ADVENT_PROFILE_SCOPE("blockTransfer");
+  const int64_t nCards{static_cast<int64_t>(nMatches.size())};
+  const int64_t nLanes{window + 1};
+
+  // The copies handed to cards [i, i + window] by the cards of the block
+  // before `i`, in a ring indexed by card modulo `nLanes`
+  std::vector<uint64_t> pending(nLanes * nLanes, 0);
+  auto pendingFor{[&](int64_t cardId) {
+    return pending.data() + ((cardId - begin) % nLanes) * nLanes;
+  }};
+
+  BlockTransfer retTransfer{std::vector<uint64_t>(window * nLanes, 0),
+                            std::vector<uint64_t>(nLanes, 0)};
+  std::vector<uint64_t> copies(nLanes);
+
+  for (int64_t i{begin}; i < end; i++) {
+    // Every card starts with its original, plus what the cards before the
+    // block and the cards of the block hand to it
+    uint64_t *handedIn{pendingFor(i)};
+    std::copy(handedIn, handedIn + nLanes, copies.begin());
+    copies[window] += 1;
+    if (i - begin < window) {
+      copies[i - begin] += 1;
+    }
+
+    // The slot is reused for card `i + nLanes`, which nothing reaches yet
+    std::fill(handedIn, handedIn + nLanes, 0);
+
+    for (int64_t lane{0}; lane < nLanes; lane++) {
+      retTransfer.total[lane] += copies[lane];
+    }
+
+    // Cards only hand out copies if all of them fit in the deck
+    if (nMatches[i] == 0 || i + nMatches[i] >= nCards) {
+      continue;
+    }
+    for (int64_t target{i + 1}; target <= i + nMatches[i]; target++) {
+      uint64_t *targetPending{pendingFor(target)};
+      for (int64_t lane{0}; lane < nLanes; lane++) {
+        targetPending[lane] += copies[lane];
+      }
+    }
+  }
+
+  // The copies that leave the block, including those that cards before the
+  // block hand past a block shorter than `window`
+  for (int64_t k{0}; k < window; k++) {
+    uint64_t *row{retTransfer.outgoing.data() + k * nLanes};
+    const uint64_t *handedOut{pendingFor(end + k)};
+    std::copy(handedOut, handedOut + nLanes, row);
+
+    if (end + k - begin < window) {
+      row[end + k - begin] += 1;
+    }
+  }
+
+  return retTransfer;
+}
+
+uint64_t evaluate(const uint64_t *coefficients,
+                  const std::vector<uint64_t> &state) {
+  // The affine function with `coefficients`, at `state`
+  uint64_t retValue{0};
+  for (size_t lane{0}; lane < state.size(); lane++) {
+    retValue += coefficients[lane] * state[lane];
+  }
+
+  return retValue;
+}
+
+} // namespace
+
+uint64_t countCardCopies(const std::vector<int32_t> &nMatches,
+                         ThreadPool *pool) {
+  ADVENT_PROFILE_SCOPE("countCardCopies");
+  const int64_t nCards{static_cast<int64_t>(nMatches.size())};
+  if (nCards == 0) {
+    return 0;
+  }
+
+  const int64_t window{*std::max_element(nMatches.cbegin(), nMatches.cend())};
+
+  // A few blocks per thread, so that uneven blocks even out
+  int64_t blockSize{nCards};
+  if (pool != nullptr) {
+    const int64_t nTasks{4 * static_cast<int64_t>(pool->size())};
+    blockSize = std::max(MIN_BLOCK_SIZE, (nCards + nTasks - 1) / nTasks);
+  }
+  const int64_t nBlocks{(nCards + blockSize - 1) / blockSize};
+  ADVENT_PROFILE_COUNT("day4.cascadeBlocks", nBlocks);
+
+  // The blocks are profiled under this span, whichever thread they run on
+  const ScopedTimer *const profileScope{ADVENT_PROFILE_CURRENT_SCOPE()};
+
+  std::vector<std::future<BlockTransfer>> transfers;
+  transfers.reserve(nBlocks);
+  for (int64_t block{0}; block < nBlocks; block++) {
+    const int64_t begin{block * blockSize};
+    const int64_t end{std::min(nCards, begin + blockSize)};
+    auto task{[&nMatches, begin, end, window, profileScope]() {
+      ADVENT_PROFILE_ADOPT_SCOPE(profileScope);
+      return blockTransfer(nMatches, begin, end, window);
+    }};
+
+    if (pool != nullptr && nBlocks > 1) {
+      transfers.push_back(pool->submit(task));
+    } else {
+      std::promise<BlockTransfer> transfer;
+      transfer.set_value(task());
+      transfers.push_back(transfer.get_future());
+    }
+  }
+
+  // Prefix pass, the first block starts with nothing handed to it
+  std::vector<uint64_t> state(window + 1, 0);
+  state[window] = 1;
+  std::vector<uint64_t> nextState(window + 1, 0);
+  nextState[window] = 1;
+
+  uint64_t retTotal{0};
+  for (std::future<BlockTransfer> &future : transfers) {
+    const BlockTransfer transfer{future.get()};
+    retTotal += evaluate(transfer.total.data(), state);
+
+    for (int64_t k{0}; k < window; k++) {
+      nextState[k] = evaluate(transfer.outgoing.data() + k * (window + 1), state);
+    }
+    std::swap(state, nextState);
+  }
+
+  return retTotal;
+}
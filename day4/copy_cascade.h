@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "advent_support/thread_pool.h"
+
+// The total number of card copies that part B ends up with, given the number
+// of matches of every card. The total wraps around modulo 2^64.
+//
+// Card `i` hands its copies to the next `nMatches[i]` cards, so the cascade is
+// a linear recurrence over a window of `max(nMatches)` cards. The deck is split
+// into blocks, and each block's effect is computed in parallel on `pool` as an
+// affine transfer function of the copies that earlier cards hand into it. A
+// sequential prefix pass over the transfer functions then stitches the blocks
+// together. `pool == nullptr` runs a single block on the calling thread.
+uint64_t countCardCopies(const std::vector<int32_t> &nMatches,
+                         ThreadPool *pool = nullptr);
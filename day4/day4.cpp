@@ -1,166 +1,277 @@
 #include <algorithm>
-#include <cassert>
+#include <array>
 #include <cstdint>
 #include <iostream>
-#include <memory>
+#include <memory_resource>
 #include <numeric>
-#include <regex>
 #include <set>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "advent_support/arena.h"
+#include "advent_support/cpu_dispatch.h"
 #include "advent_support/fileio.h"
-
-void parseCard(const std::string &cardLine,
-               std::set<int32_t> &retWinningNumbers,
-               std::set<int32_t> &retTrialNumbers) {
-  std::string::const_iterator substring_cbegin{cardLine.cbegin()};
-  const std::string::const_iterator substring_cend{cardLine.cend()};
-
-  std::smatch matches;
-  const std::regex cardHeaderRegex{"Card\\s+\\d+:"};
-  const std::regex numberRegex{"^\\s{1,2}(\\d+)"};
-  const std::regex dividerRegex{"^ \\|"};
-
-  // Consume the card header
-  if (std::regex_search(substring_cbegin, substring_cend, matches,
-                        cardHeaderRegex)) {
-    // Advance the iterator
-    substring_cbegin = matches.suffix().first;
-  } else {
-    throw std::runtime_error("Malformed input line: " + cardLine);
+#include "advent_support/incremental.h"
+#include "advent_support/pipeline.h"
+#include "advent_support/profiling.h"
+#include "advent_support/solver.h"
+#include "advent_support/thread_pool.h"
+#include "copy_cascade.h"
+
+namespace day4 {
+
+void decodeCardNumbers(const char *begin, const char *end,
+                       std::pmr::set<int32_t> &retNumbers) {
+  // Decoded by the vectorized kernel the CPU supports best. Cards rarely
+  // have more numbers than fit on the stack
+  std::array<int32_t, 64> numbers;
+  const int64_t nNumbers{
+      decodeNumbers(begin, end - begin, numbers.data(), numbers.size())};
+  ADVENT_PROFILE_COUNT("day4.numbersDecoded", nNumbers);
+
+  if (nNumbers <= static_cast<int64_t>(numbers.size())) {
+    retNumbers.insert(numbers.cbegin(), numbers.cbegin() + nNumbers);
+    return;
   }
 
-  // Consume the winning numbers
-  while (std::regex_search(substring_cbegin, substring_cend, matches,
-                           numberRegex)) {
-    assert(matches.size() == 2 && "Unexpected number of matches");
-
-    // Extract the matched grouping
-    const int32_t number{std::stoi(matches[1])};
-    retWinningNumbers.insert(number);
-
-    // Advance the iterator
-    substring_cbegin = matches.suffix().first;
-  }
+  std::pmr::vector<int32_t> allNumbers(nNumbers,
+                                       retNumbers.get_allocator().resource());
+  decodeNumbers(begin, end - begin, allNumbers.data(), nNumbers);
+  retNumbers.insert(allNumbers.cbegin(), allNumbers.cend());
+}
 
-  // Consume the divider
-  if (std::regex_search(substring_cbegin, substring_cend, matches,
-                        dividerRegex)) {
-    // Advance the iterator
-    substring_cbegin = matches.suffix().first;
-  } else {
+void parseCard(const std::string &cardLine,
+               std::pmr::set<int32_t> &retWinningNumbers,
+               std::pmr::set<int32_t> &retTrialNumbers) {
+  // The card is `Card <id>: <winning numbers> | <trial numbers>`
+  const size_t header{cardLine.find(':')};
+  const size_t divider{cardLine.find('|', header)};
+  if (header == std::string::npos || divider == std::string::npos) {
     throw std::runtime_error("Malformed input line: " + cardLine);
   }
 
-  // Consume the trial numbers
-  while (std::regex_search(substring_cbegin, substring_cend, matches,
-                           numberRegex)) {
-    assert(matches.size() == 2 && "Unexpected number of matches");
-
-    // Extract the matched grouping
-    const int32_t number{std::stoi(matches[1])};
-    retTrialNumbers.insert(number);
-
-    // Advance the iterator
-    substring_cbegin = matches.suffix().first;
-  }
+  const char *data{cardLine.data()};
+  decodeCardNumbers(data + header + 1, data + divider, retWinningNumbers);
+  decodeCardNumbers(data + divider + 1, data + cardLine.size(),
+                    retTrialNumbers);
+}
 
-  // Assert that the entire string was consumed
-  assert(substring_cbegin == substring_cend &&
-         "Failed to consume entire string");
+int32_t countMatches(const std::string &cardLine, Arena &arena) {
+  /**
+   * The number of trial numbers of `cardLine` that are winning numbers.
+   * Resets `arena`, which holds the parse state.
+   **/
+  // Everything allocated from `arena` on the previous card is gone by now
+  arena.reset();
+  std::pmr::set<int32_t> winningNumbers{arena.resource()};
+  std::pmr::set<int32_t> trialNumbers{arena.resource()};
+
+  // Parse the card
+  parseCard(cardLine, winningNumbers, trialNumbers);
+
+  // Find the intersection of `winningNumbers` and `trialNumbers`
+  std::pmr::set<int32_t> intersection{arena.resource()};
+  std::set_intersection(winningNumbers.cbegin(), winningNumbers.cend(),
+                        trialNumbers.cbegin(), trialNumbers.cend(),
+                        std::inserter(intersection, intersection.begin()));
+
+  return static_cast<int32_t>(intersection.size());
 }
 
-void partA(const std::string &filename) {
-  std::vector<std::string> lines{readFileAsLines(filename)};
+void partA(const std::string &filename, std::ostream &out) {
+  ADVENT_PROFILE_SCOPE("partA");
 
+  // Cards are scored on the pipeline's threads while the rest of the file is
+  // still being read, each thread with an arena of its own
   int32_t cumulativeScore{0};
-  for (const std::string &line : lines) {
-    std::set<int32_t> winningNumbers;
-    std::set<int32_t> trialNumbers;
-
-    // Parse the card
-    parseCard(line, winningNumbers, trialNumbers);
-
-    // Find the intersection of `winningNumbers` and `trialNumbers`
-    std::set<int32_t> intersection;
-    std::set_intersection(winningNumbers.cbegin(), winningNumbers.cend(),
-                          trialNumbers.cbegin(), trialNumbers.cend(),
-                          std::inserter(intersection, intersection.begin()));
-
-    // Calculate the score
-    if (intersection.size() > 0) {
-      int32_t score{0b1 << (intersection.size() - 1)};
-      cumulativeScore += score;
-    }
-  }
-
-  std::cout << "Part A: The cumulative score is: " << cumulativeScore
-            << std::endl;
+  runLinePipeline(
+      filename,
+      [](const std::string &line) {
+        ADVENT_PROFILE_COUNT("day4.lines", 1);
+        thread_local Arena arena;
+        return countMatches(line, arena);
+      },
+      [&cumulativeScore](int64_t, const int32_t nMatches) {
+        // Calculate the score
+        if (nMatches > 0) {
+          int32_t score{0b1 << (nMatches - 1)};
+          cumulativeScore += score;
+        }
+      });
+
+  out << "Part A: The cumulative score is: " << cumulativeScore << std::endl;
 
   return;
 }
 
-void partB(const std::string &filename) {
-  std::vector<std::string> lines{readFileAsLines(filename)};
-  std::unique_ptr<int32_t[]> nCardCopies{new int32_t[lines.size()]};
+// Decks with fewer cards than this are solved on the calling thread
+const int64_t PARALLEL_MIN_CARDS{32 * 1024};
+
+void partB(const std::string &filename, std::ostream &out) {
+  ADVENT_PROFILE_SCOPE("partB");
+
+  // Every card parses on its own, on the pipeline's threads, and the match
+  // counts arrive in batches in any order
+  std::vector<int32_t> nMatches;
+  runLinePipeline(
+      filename,
+      [](const std::string &line) {
+        ADVENT_PROFILE_COUNT("day4.lines", 1);
+        thread_local Arena arena;
+        return countMatches(line, arena);
+      },
+      [&nMatches](const int64_t card, const int32_t cardMatches) {
+        if (card >= static_cast<int64_t>(nMatches.size())) {
+          nMatches.resize(card + 1);
+        }
+        nMatches[card] = cardMatches;
+      });
+  ADVENT_PROFILE_SCOPE("solve");
+  const int64_t nCards{static_cast<int64_t>(nMatches.size())};
+
+  // Small decks are not worth handing to the pipeline's threads
+  ThreadPool *pool{nCards >= PARALLEL_MIN_CARDS ? &pipelinePool() : nullptr};
+
+  // The copy counts wrap around like the `int32_t` counters always did
+  const int32_t cumulativeCopies{
+      static_cast<int32_t>(countCardCopies(nMatches, pool))};
 
-  // Initialize the number of copies of each card to 1
-  std::fill(nCardCopies.get(), nCardCopies.get() + lines.size(), 1);
+  out << "Part B: The cumulative number of copies is: "
+      << cumulativeCopies << std::endl;
 
-  int32_t cardId{0};
-  for (const std::string &line : lines) {
-    std::set<int32_t> winningNumbers;
-    std::set<int32_t> trialNumbers;
+  return;
+}
 
-    // Parse the card
-    parseCard(line, winningNumbers, trialNumbers);
+void solveIncremental(const std::string &filename, std::ostream &out) {
+  /**
+   * Solve both parts, only re-parsing the blocks of `filename` that changed
+   * since the previous incremental run. The part B copy counts are only
+   * recomputed from the first card they could have changed for.
+   **/
+  ADVENT_PROFILE_SCOPE("solveIncremental");
+  std::vector<std::string> lines{readFileAsLines(filename)};
+  const int64_t nCards{static_cast<int64_t>(lines.size())};
 
-    // Find the intersection of `winningNumbers` and `trialNumbers`
-    std::set<int32_t> intersection;
-    std::set_intersection(winningNumbers.cbegin(), winningNumbers.cend(),
-                          trialNumbers.cbegin(), trialNumbers.cend(),
-                          std::inserter(intersection, intersection.begin()));
+  // Each block's values are the number of matches of each of its cards,
+  // followed by the number of copies of each of them
+  BlockCache cache{filename, "day4", 0, 2};
 
-    const int32_t nCopies{nCardCopies[cardId]};
-    const int32_t nIntersection{static_cast<int32_t>(intersection.size())};
+  int64_t nCachedCards{0};
+  for (int64_t block{0}; block < cache.nBlocks(); block++) {
+    nCachedCards += static_cast<int64_t>(cache.values(block).size()) / 2;
+  }
 
-    // Add `nCopies` to `nCardCopies` for each card
-    // from [cardId + 1, cardId + nIntersection]
-    for (int32_t i{cardId + 1}; i <= cardId + nIntersection; ++i) {
-      // Prevent an overflow
-      if (cardId + nIntersection >= static_cast<int32_t>(lines.size())) {
-        break;
-      }
+  const int64_t firstChangedBlock{
+      cache.refresh(lines, [&lines](int64_t begin, int64_t end) {
+        Arena arena;
+        std::vector<int64_t> values(2 * (end - begin), 0);
+        for (int64_t i{begin}; i < end; i++) {
+          values[i - begin] = countMatches(lines[i], arena);
+        }
+        return values;
+      })};
+
+  std::vector<int64_t> nMatches(nCards);
+  std::vector<int64_t> nCardCopies(nCards);
+  int64_t maxMatches{0};
+  for (int64_t block{0}; block < cache.nBlocks(); block++) {
+    const std::vector<int64_t> &values{cache.values(block)};
+    const int64_t blockSize{static_cast<int64_t>(values.size()) / 2};
+
+    for (int64_t k{0}; k < blockSize; k++) {
+      nMatches[block * BlockCache::BLOCK_SIZE + k] = values[k];
+      nCardCopies[block * BlockCache::BLOCK_SIZE + k] = values[blockSize + k];
+      maxMatches = std::max(maxMatches, values[k]);
+    }
+  }
 
-      nCardCopies[i] += nCopies;
+  // A card only hands out copies if all of them fit in the deck, so a
+  // change in the deck size can change the copies of the last cards before
+  // the first changed block too
+  int64_t firstCard{firstChangedBlock * BlockCache::BLOCK_SIZE};
+  if (nCachedCards != nCards) {
+    firstCard =
+        std::min(firstCard, std::min(nCachedCards, nCards) - maxMatches);
+  }
+  firstCard = std::clamp<int64_t>(firstCard, 0, nCards);
+  ADVENT_PROFILE_COUNT("day4.copiesRecounted", nCards - firstCard);
+
+  auto handOutCopies{[&](int64_t cardId, int64_t from) {
+    // Add the copies of `cardId` to each card from
+    // [max(cardId + 1, from), cardId + nMatches]
+    if (cardId + nMatches[cardId] >= nCards) {
+      return;
     }
+    for (int64_t i{std::max(cardId + 1, from)}; i <= cardId + nMatches[cardId];
+         i++) {
+      nCardCopies[i] += nCardCopies[cardId];
+    }
+  }};
+
+  // The cards before `firstCard` are final. Replay the copies that they hand
+  // out to the cards from `firstCard` onward, then redo the cascade there
+  std::fill(nCardCopies.begin() + firstCard, nCardCopies.end(), 1);
+  for (int64_t j{std::max<int64_t>(0, firstCard - maxMatches)}; j < firstCard;
+       j++) {
+    handOutCopies(j, firstCard);
+  }
+  for (int64_t j{firstCard}; j < nCards; j++) {
+    handOutCopies(j, firstCard);
+  }
 
-    // Increment the card ID
-    cardId++;
+  // Store the new copy counts back into the cache
+  for (int64_t block{firstCard / BlockCache::BLOCK_SIZE};
+       block < cache.nBlocks(); block++) {
+    std::vector<int64_t> values{cache.values(block)};
+    const int64_t blockSize{static_cast<int64_t>(values.size()) / 2};
+
+    for (int64_t k{0}; k < blockSize; k++) {
+      values[blockSize + k] = nCardCopies[block * BlockCache::BLOCK_SIZE + k];
+    }
+    cache.setValues(block, std::move(values));
   }
+  cache.save();
 
-  const int32_t cumulativeCopies{
-      std::accumulate(nCardCopies.get(), nCardCopies.get() + lines.size(), 0)};
+  int32_t cumulativeScore{0};
+  for (const int64_t matches : nMatches) {
+    if (matches > 0) {
+      cumulativeScore += 0b1 << (matches - 1);
+    }
+  }
 
-  std::cout << "Part B: The cumulative number of copies is: "
-            << cumulativeCopies << std::endl;
+  const int32_t cumulativeCopies{static_cast<int32_t>(
+      std::accumulate(nCardCopies.cbegin(), nCardCopies.cend(), int64_t{0}))};
 
-  return;
+  out << "Part A: The cumulative score is: " << cumulativeScore << std::endl;
+  out << "Part B: The cumulative number of copies is: " << cumulativeCopies
+      << std::endl;
 }
 
+// Register this day with the multi-day runner
+const SolverRegistration registration{"day4", partA, partB};
+
+} // namespace day4
+
+// The multi-day runner links every day together and provides its own `main`
+#ifndef ADVENT_RUNNER
 int32_t main(int argc, char *argv[]) {
   // Check that the filename is provided
   // if (argc != 2) {
   //   std::cerr << "Usage: " << argv[0] << " <input_file>" << std::endl;
   //   return 1;
   // }
-  const std::string filename{argc == 2 ? argv[1] : "input_small.txt"};
+  const std::string filename{argc >= 2 ? argv[argc - 1] : "input_small.txt"};
 
   try {
-    partA(filename);
-    partB(filename);
+    // `--incremental` reuses the partial results cached by the previous run
+    if (argc == 3 && std::string{argv[1]} == "--incremental") {
+      day4::solveIncremental(filename, std::cout);
+      return 0;
+    }
+
+    day4::partA(filename, std::cout);
+    day4::partB(filename, std::cout);
   } catch (const std::exception &exception) {
     std::cerr << exception.what() << std::endl;
     return 1;
@@ -168,3 +279,4 @@ int32_t main(int argc, char *argv[]) {
 
   return 0;
 }
+#endif
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "composed_mapping.h"
+
+namespace {
+
+const int64_t DOMAIN_END{std::numeric_limits<int64_t>::max()};
+
+struct Piece {
+  int64_t start;
+  int64_t end;
+  int64_t offset;
+};
+
+std::vector<Piece> toPieces(const RangeMapping &mapping) {
+  /**
+   * Express `mapping` as sorted pieces covering [0, DOMAIN_END), filling the
+   * gaps between its ranges with identity pieces.
+   **/
+  std::vector<std::tuple<int64_t, int64_t, int64_t>> ranges{mapping.ranges()};
+  std::sort(ranges.begin(), ranges.end());
+
+  std::vector<Piece> retPieces;
+  retPieces.reserve(2 * ranges.size() + 1);
+
+  int64_t covered{0};
+  for (const auto &[source, destination, length] : ranges) {
+    assert(source >= covered && "Overlapping mapping ranges");
+
+    if (length <= 0) {
+      continue;
+    }
+
+    if (source > covered) {
+      retPieces.push_back({covered, source, 0});
+    }
+    retPieces.push_back({source, source + length, destination - source});
+    covered = source + length;
+  }
+
+  if (covered < DOMAIN_END) {
+    retPieces.push_back({covered, DOMAIN_END, 0});
+  }
+
+  return retPieces;
+}
+
+std::vector<Piece> compose(const std::vector<Piece> &pieces,
+                           const std::vector<Piece> &next) {
+  /**
+   * Compose `next` after `pieces`: split every piece wherever its image
+   * crosses a boundary of `next`.
+   **/
+  std::vector<Piece> retPieces;
+  retPieces.reserve(pieces.size() + next.size());
+
+  for (const Piece &piece : pieces) {
+    const int64_t imageStart{piece.start + piece.offset};
+    const int64_t imageEnd{piece.end + piece.offset};
+
+    // The first piece of `next` that contains `imageStart`
+    auto it{std::upper_bound(
+        next.cbegin(), next.cend(), imageStart,
+        [](const int64_t value, const Piece &p) { return value < p.start; })};
+    --it;
+
+    for (; it != next.cend() && it->start < imageEnd; ++it) {
+      const int64_t overlapStart{std::max(imageStart, it->start)};
+      const int64_t overlapEnd{std::min(imageEnd, it->end)};
+      const int64_t offset{piece.offset + it->offset};
+
+      // Merge with the previous piece when the translation carries on
+      if (!retPieces.empty() && retPieces.back().offset == offset &&
+          retPieces.back().end == overlapStart - piece.offset) {
+        retPieces.back().end = overlapEnd - piece.offset;
+      } else {
+        retPieces.push_back(
+            {overlapStart - piece.offset, overlapEnd - piece.offset, offset});
+      }
+    }
+  }
+
+  return retPieces;
+}
+
+} // namespace
+
+ComposedMapping::ComposedMapping(const std::vector<RangeMapping> &mappings) {
+  std::vector<Piece> pieces{{0, DOMAIN_END, 0}};
+  for (const RangeMapping &mapping : mappings) {
+    pieces = compose(pieces, toPieces(mapping));
+  }
+
+  mStarts.reserve(pieces.size());
+  mOffsets.reserve(pieces.size());
+  for (const Piece &piece : pieces) {
+    mStarts.push_back(piece.start);
+    mOffsets.push_back(piece.offset);
+  }
+
+  // Build the reverse index
+  std::vector<PieceImage> images;
+  images.reserve(pieces.size());
+  for (size_t i{0}; i < pieces.size(); i++) {
+    images.push_back({pieces[i].start + pieces[i].offset,
+                      pieces[i].end + pieces[i].offset,
+                      static_cast<int64_t>(i)});
+  }
+  std::sort(images.begin(), images.end(),
+            [](const PieceImage &a, const PieceImage &b) {
+              return a.start < b.start;
+            });
+  addImageNode(std::move(images));
+}
+
+int32_t ComposedMapping::addImageNode(std::vector<PieceImage> images) {
+  /**
+   * The center is the median start, so the node holds at least the image
+   * starting there, and each subtree at most half of `images`: the tree is
+   * O(log n) deep. The subtrees keep the images sorted by start.
+   **/
+  if (images.empty()) {
+    return NO_NODE;
+  }
+
+  const int64_t center{images[images.size() / 2].start};
+  std::vector<PieceImage> below;
+  std::vector<PieceImage> above;
+  std::vector<PieceImage> containing;
+  for (const PieceImage &image : images) {
+    if (image.end <= center) {
+      below.push_back(image);
+    } else if (image.start > center) {
+      above.push_back(image);
+    } else {
+      containing.push_back(image);
+    }
+  }
+  images = {};
+
+  const int32_t node{static_cast<int32_t>(mImageNodes.size())};
+  const int64_t begin{static_cast<int64_t>(mByImageStart.size())};
+  for (const PieceImage &image : containing) {
+    mByImageStart.emplace_back(image.start, image.piece);
+  }
+  std::sort(containing.begin(), containing.end(),
+            [](const PieceImage &a, const PieceImage &b) {
+              return a.end > b.end;
+            });
+  for (const PieceImage &image : containing) {
+    mByImageEnd.emplace_back(image.end, image.piece);
+  }
+  mImageNodes.push_back({center, begin,
+                         static_cast<int64_t>(mByImageStart.size()), NO_NODE,
+                         NO_NODE});
+
+  // Not through a reference, the nodes move as the subtrees are added
+  const int32_t belowRoot{addImageNode(std::move(below))};
+  mImageNodes[node].below = belowRoot;
+  const int32_t aboveRoot{addImageNode(std::move(above))};
+  mImageNodes[node].above = aboveRoot;
+
+  return node;
+}
+
+int64_t ComposedMapping::findPiece(const int64_t value) const {
+  return std::upper_bound(mStarts.cbegin(), mStarts.cend(), value) -
+         mStarts.cbegin() - 1;
+}
+
+int64_t ComposedMapping::mapValue(const int64_t value) const {
+  // Values outside of the domain are not touched by any mapping
+  if (value < 0) {
+    return value;
+  }
+
+  return value + mOffsets[findPiece(value)];
+}
+
+std::vector<int64_t> ComposedMapping::unmapValue(const int64_t location) const {
+  std::vector<int64_t> retSeeds;
+
+  if (location < 0) {
+    retSeeds.push_back(location);
+    return retSeeds;
+  }
+
+  // A node's images all contain its center. Below the center, those that
+  // start at or before `location` contain it too, and at or above it, those
+  // that end after `location`. The rest of the images are on one side only,
+  // so a single path down the tree visits every image containing `location`,
+  // and stops scanning a node at its first image that does not
+  for (int32_t node{mImageNodes.empty() ? NO_NODE : 0}; node != NO_NODE;) {
+    const ImageNode &imageNode{mImageNodes[node]};
+
+    if (location < imageNode.center) {
+      for (int64_t k{imageNode.begin};
+           k < imageNode.end && mByImageStart[k].first <= location; k++) {
+        retSeeds.push_back(location - mOffsets[mByImageStart[k].second]);
+      }
+      node = imageNode.below;
+    } else {
+      for (int64_t k{imageNode.begin};
+           k < imageNode.end && mByImageEnd[k].first > location; k++) {
+        retSeeds.push_back(location - mOffsets[mByImageEnd[k].second]);
+      }
+      node = imageNode.above;
+    }
+  }
+
+  std::sort(retSeeds.begin(), retSeeds.end());
+  return retSeeds;
+}
+
+int64_t ComposedMapping::minimumLocation(
+    const std::vector<std::pair<int64_t, int64_t>> &ranges) const {
+  int64_t retMinimum{std::numeric_limits<int64_t>::max()};
+
+  for (const auto &[rangeStart, rangeLength] : ranges) {
+    if (rangeLength <= 0) {
+      continue;
+    }
+
+    // Negative seeds are outside of the domain and map to themselves
+    if (rangeStart < 0) {
+      retMinimum = std::min(retMinimum, rangeStart);
+    }
+
+    // Each piece is a translation, so its smallest location is at the
+    // smallest seed of the range that it contains
+    const int64_t rangeEnd{rangeStart + rangeLength};
+    for (int64_t i{findPiece(std::max<int64_t>(rangeStart, 0))};
+         i < nPieces() && mStarts[i] < rangeEnd; i++) {
+      const int64_t seed{std::max(rangeStart, mStarts[i])};
+      retMinimum = std::min(retMinimum, seed + mOffsets[i]);
+    }
+  }
+
+  return retMinimum;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "range_mapping.h"
+
+class ComposedMapping {
+  /**
+   * The composition of a chain of `RangeMapping`s, flattened into a single
+   * piecewise translation `x -> x + offset` over sorted, disjoint pieces that
+   * cover [0, INT64_MAX). A point query is a binary search instead of a walk
+   * over every range of every mapping, and the reverse query a walk down an
+   * interval tree over the images of the pieces.
+   *
+   * Assumes that the ranges within each `RangeMapping` do not overlap, which
+   * holds for every almanac.
+   **/
+public:
+  explicit ComposedMapping(const std::vector<RangeMapping> &mappings);
+
+  // Seed -> location
+  int64_t mapValue(const int64_t value) const;
+
+  // Location -> every seed that maps to it, in ascending order
+  std::vector<int64_t> unmapValue(const int64_t location) const;
+
+  // The smallest location reachable from any of the (start, length) `ranges`
+  int64_t
+  minimumLocation(const std::vector<std::pair<int64_t, int64_t>> &ranges) const;
+
+  int64_t nPieces() const { return static_cast<int64_t>(mStarts.size()); }
+
+private:
+  // The image [start, end) of piece `piece`
+  struct PieceImage {
+    int64_t start;
+    int64_t end;
+    int64_t piece;
+  };
+
+  // A node of the reverse index holds the images containing its `center`,
+  // and its subtrees those entirely below and entirely above it
+  struct ImageNode {
+    int64_t center;
+    // The node's images are [begin, end) of `mByImageStart` and
+    // `mByImageEnd`
+    int64_t begin;
+    int64_t end;
+    int32_t below;
+    int32_t above;
+  };
+
+  static constexpr int32_t NO_NODE{-1};
+
+  // Index of the piece containing `value`, which must be non-negative
+  int64_t findPiece(const int64_t value) const;
+
+  // Add the subtree of `images`, sorted by start, returning its root
+  int32_t addImageNode(std::vector<PieceImage> images);
+
+  // Piece `i` is [mStarts[i], mStarts[i + 1]) -> + mOffsets[i], with the last
+  // piece ending at INT64_MAX
+  std::vector<int64_t> mStarts{};
+  std::vector<int64_t> mOffsets{};
+
+  // The reverse index, a centered interval tree rooted at node 0. Each
+  // node's images are listed as (start, piece) by ascending start, and as
+  // (end, piece) by descending end
+  std::vector<ImageNode> mImageNodes{};
+  std::vector<std::pair<int64_t, int64_t>> mByImageStart{};
+  std::vector<std::pair<int64_t, int64_t>> mByImageEnd{};
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "composed_mapping.h"
+
+// The parts of day5 that long-lived callers, such as the solver server, reuse
+// across requests
+
+namespace day5 {
+
+// The mappings of the almanac in `almanacFilename`, fused into one
+ComposedMapping composeAlmanac(const std::string &almanacFilename);
+
+// Answer the `seed`, `location` and `minimum` queries in `queries`, one answer
+// line per query line
+std::string answerQueries(const ComposedMapping &composed,
+                          std::string_view queries);
+
+} // namespace day5
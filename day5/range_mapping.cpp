@@ -1,32 +1,113 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <memory_resource>
 #include <utility>
 #include <vector>
 
+#include "advent_support/cpu_dispatch.h"
 #include "range_mapping.h"
 
+namespace {
+
+// Maps with at most this many ranges are scanned whole in `mapValue`. The
+// scan's cost grows linearly, and the binary search only catches up at about
+// 256 ranges
+const int64_t LINEAR_SCAN_MAX_RANGES{128};
+
+} // namespace
+
+void RangeMapping::sortRanges() {
+  std::sort(mRanges.begin(), mRanges.end());
+
+  for (size_t i{0}; i < mRanges.size(); i++) {
+    const auto &[source, destination, length]{mRanges[i]};
+    mSourceStarts[i] = source;
+    mSourceEnds[i] = source + length;
+  }
+}
+
 int64_t RangeMapping::mapValue(const int64_t value) const {
-  // First look if `value` is within any of the ranges
-  for (const auto &[source, destination, length] : mRanges) {
-    // If `value` is within [source, source + length)
-    if (value >= source && value < source + length) {
-      return destination + (value - source);
+  /**
+   * The ranges are sorted and do not overlap, so the only one that can hold
+   * `value` is the last one starting at or before it. Small maps are scanned
+   * whole with the vectorized kernel the CPU supports best instead, which
+   * beats the binary search's unpredictable branches there.
+   **/
+  const int64_t nRanges{static_cast<int64_t>(mRanges.size())};
+  int64_t index{nRanges};
+
+  if (nRanges <= LINEAR_SCAN_MAX_RANGES) {
+    index = findContainingRange(mSourceStarts.data(), mSourceEnds.data(),
+                                nRanges, value);
+  } else {
+    const int64_t after{
+        std::upper_bound(mSourceStarts.cbegin(), mSourceStarts.cend(), value) -
+        mSourceStarts.cbegin()};
+    if (after > 0 && mSourceEnds[after - 1] > value) {
+      index = after - 1;
     }
   }
 
+  if (index < nRanges) {
+    const auto &[source, destination, length]{mRanges[index]};
+    return destination + (value - source);
+  }
+
   // If not, then `value` is maps to itself
   return value;
 }
 
-std::vector<std::pair<int64_t, int64_t>>
-RangeMapping::mapRange(const std::pair<int64_t, int64_t> &range) const {
+void RangeMapping::mapSortedValues(const std::vector<int64_t> &sorted,
+                                   std::vector<int64_t> &retMapped) const {
+  /**
+   * A merge of the values with the ranges: both ascend, so a range ending at
+   * or before a value cannot hold any value after it either. The range the
+   * walk stops at holds the value unless it starts after it, in which case
+   * every range after it does too. That is the range `mapValue` would find.
+   **/
+  retMapped.resize(sorted.size());
+
+  size_t range{0};
+  for (size_t i{0}; i < sorted.size(); i++) {
+    const int64_t value{sorted[i]};
+    while (range < mRanges.size() && mSourceEnds[range] <= value) {
+      range++;
+    }
+
+    if (range < mRanges.size() && mSourceStarts[range] <= value) {
+      const auto &[source, destination, length]{mRanges[range]};
+      retMapped[i] = destination + (value - source);
+    } else {
+      retMapped[i] = value;
+    }
+  }
+}
+
+std::pmr::vector<std::pair<int64_t, int64_t>>
+RangeMapping::mapRange(const std::pair<int64_t, int64_t> &range,
+                       std::pmr::memory_resource *resource) const {
   auto [rangeStart, rangeLength]{range};
 
-  std::vector<std::pair<int64_t, int64_t>> retRanges{};
+  std::pmr::vector<std::pair<int64_t, int64_t>> retRanges{resource};
+
+  // First look if `range` is within any of the mapping ranges. They are
+  // sorted, so whatever precedes the current mapping range is not mapped,
+  // and the search can start at the first one that ends after `rangeStart`
+  auto it{std::partition_point(
+      mRanges.cbegin(), mRanges.cend(), [rangeStart](const auto &mapping) {
+        const auto &[source, destination, mappingLength]{mapping};
+        return source + mappingLength <= rangeStart;
+      })};
+  for (; it != mRanges.cend(); it++) {
+    const auto &[source, destination, mappingLength]{*it};
+
+    // Nothing left to map, and an empty range must not be emitted. The
+    // remaining mapping ranges all start after `range` ends
+    if (rangeLength == 0 || source >= rangeStart + rangeLength) {
+      break;
+    }
 
-  // First look if `range` is within any of the mapping ranges
-  for (const auto &[source, destination, mappingLength] : mRanges) {
     // Case 1: `range` is completely inside the mapping range
     if (rangeStart >= source &&
         rangeStart + rangeLength <= source + mappingLength) {
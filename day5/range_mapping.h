@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory_resource>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -11,14 +12,40 @@ public:
 
   void addRange(const int64_t start, const int64_t end, const int64_t length) {
     mRanges.emplace_back(start, end, length);
+    mSourceStarts.push_back(start);
+    mSourceEnds.push_back(start + length);
   }
 
+  // Sort the ranges by source. `mapRange` needs the ranges sorted
+  void sortRanges();
+
+  // The ranges have to be sorted
   int64_t mapValue(const int64_t value) const;
 
-  std::vector<std::pair<int64_t, int64_t>>
-  mapRange(const std::pair<int64_t, int64_t> &range) const;
+  // `mapValue` of every value of `sorted`, which has to be sorted ascending,
+  // into `retMapped`, in the same order. The ranges have to be sorted
+  void mapSortedValues(const std::vector<int64_t> &sorted,
+                       std::vector<int64_t> &retMapped) const;
+
+  // The (source, destination, length) ranges, in insertion order until
+  // `sortRanges()` is called
+  const std::vector<std::tuple<int64_t, int64_t, int64_t>> &ranges() const {
+    return mRanges;
+  }
+
+  // The returned ranges are allocated from `resource`. The ranges have to be
+  // sorted
+  std::pmr::vector<std::pair<int64_t, int64_t>>
+  mapRange(const std::pair<int64_t, int64_t> &range,
+           std::pmr::memory_resource *resource =
+               std::pmr::get_default_resource()) const;
 
 private:
   // The tuple holds (source, destination, length)
   std::vector<std::tuple<int64_t, int64_t, int64_t>> mRanges{};
+
+  // The sources of `mRanges` as [start, end), laid out for the vectorized
+  // lookup in `mapValue`
+  std::vector<int64_t> mSourceStarts{};
+  std::vector<int64_t> mSourceEnds{};
 };
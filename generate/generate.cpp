@@ -0,0 +1,190 @@
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "advent_support/input_generators.h"
+
+std::map<std::string, std::string> parseOptions(int argc, char *argv[]) {
+  /**
+   * Parse the `key=value` arguments following the day name.
+   **/
+  std::map<std::string, std::string> retOptions;
+
+  for (int32_t i{2}; i < argc; i++) {
+    const std::string argument{argv[i]};
+    const size_t equals{argument.find('=')};
+
+    if (equals == std::string::npos) {
+      throw std::invalid_argument("Malformed option: " + argument);
+    }
+
+    retOptions[argument.substr(0, equals)] = argument.substr(equals + 1);
+  }
+
+  return retOptions;
+}
+
+class Options {
+  /**
+   * Typed access to the `key=value` options, with a default for each
+   * missing key. Values out of their range are rejected with the key named,
+   * rather than handed to a generator, and so are the keys no generator
+   * read, which are most likely misspelled.
+   **/
+public:
+  explicit Options(std::map<std::string, std::string> options)
+      : mOptions{std::move(options)} {}
+
+  // An integer no less than `minimum`
+  int64_t integer(const std::string &key, const int64_t fallback,
+                  const int64_t minimum) {
+    mRead.insert(key);
+    const auto it{mOptions.find(key)};
+    if (it == mOptions.end()) {
+      return fallback;
+    }
+
+    const std::string &value{it->second};
+    int64_t retValue{0};
+    const auto [end, error]{
+        std::from_chars(value.data(), value.data() + value.size(), retValue)};
+    if (error != std::errc{} || end != value.data() + value.size()) {
+      throw std::invalid_argument("Malformed option: " + key + "=" + value);
+    }
+    if (retValue < minimum) {
+      throw std::invalid_argument("Option " + key + " must be at least " +
+                                  std::to_string(minimum) + ": " + value);
+    }
+
+    return retValue;
+  }
+
+  // An `int32_t` no less than `minimum`
+  int32_t integer32(const std::string &key, const int32_t fallback,
+                    const int32_t minimum) {
+    const int64_t value{integer(key, fallback, minimum)};
+    if (value > std::numeric_limits<int32_t>::max()) {
+      throw std::invalid_argument("Option " + key + " is too large: " +
+                                  std::to_string(value));
+    }
+    return static_cast<int32_t>(value);
+  }
+
+  // A probability, in [0, 1]
+  double fraction(const std::string &key, const double fallback) {
+    mRead.insert(key);
+    const auto it{mOptions.find(key)};
+    if (it == mOptions.end()) {
+      return fallback;
+    }
+
+    const std::string &value{it->second};
+    size_t end{0};
+    double retValue{0};
+    try {
+      retValue = std::stod(value, &end);
+    } catch (const std::exception &) {
+      end = 0;
+    }
+    if (end == 0 || end != value.size()) {
+      throw std::invalid_argument("Malformed option: " + key + "=" + value);
+    }
+    if (!(retValue >= 0.0 && retValue <= 1.0)) {
+      throw std::invalid_argument("Option " + key +
+                                  " must be between 0 and 1: " + value);
+    }
+
+    return retValue;
+  }
+
+  // Throw on the first option that was given but never read
+  void rejectUnread(const std::string &day) const {
+    for (const auto &[key, value] : mOptions) {
+      if (mRead.count(key) == 0) {
+        throw std::invalid_argument("Unknown option for " + day + ": " + key +
+                                    "=" + value);
+      }
+    }
+  }
+
+private:
+  std::map<std::string, std::string> mOptions;
+  std::set<std::string> mRead{};
+};
+
+std::string generate(const std::string &day, Options &options) {
+  /**
+   * Every option is read, and the unknown ones rejected, before anything is
+   * generated.
+   **/
+  const uint64_t seed{static_cast<uint64_t>(options.integer("seed", 1, 0))};
+
+  if (day == "day1") {
+    const int64_t nLines{options.integer("lines", 1000, 1)};
+    options.rejectUnread(day);
+    return generateDay1Input(nLines, seed);
+  } else if (day == "day2") {
+    const int64_t nGames{options.integer("games", 100, 1)};
+    options.rejectUnread(day);
+    return generateDay2Input(nGames, seed);
+  } else if (day == "day3") {
+    const int32_t height{options.integer32("height", 140, 1)};
+    const int32_t width{options.integer32("width", 140, 1)};
+    const double density{options.fraction("density", 0.15)};
+    options.rejectUnread(day);
+    return generateDay3Input(height, width, density, seed);
+  } else if (day == "day4") {
+    const int64_t nCards{options.integer("cards", 200, 1)};
+    const int32_t maxMatches{options.integer32("maxMatches", 10, 0)};
+    const double winRate{options.fraction("winRate", 0.1)};
+    options.rejectUnread(day);
+    return generateDay4Input(nCards, maxMatches, winRate, seed);
+  } else if (day == "day5") {
+    const int32_t nRangesPerMap{options.integer32("ranges", 40, 1)};
+    const int32_t nSeedRanges{options.integer32("seedRanges", 10, 1)};
+    options.rejectUnread(day);
+    return generateDay5Input(nRangesPerMap, nSeedRanges, seed);
+  }
+
+  throw std::invalid_argument("Unknown day: " + day);
+}
+
+void printUsage(const char *program) {
+  std::cerr << "Usage: " << program << " <dayN> [key=value ...]" << std::endl;
+  std::cerr << "  day1 lines=1000 seed=1" << std::endl;
+  std::cerr << "  day2 games=100 seed=1" << std::endl;
+  std::cerr << "  day3 height=140 width=140 density=0.15 seed=1" << std::endl;
+  std::cerr << "  day4 cards=200 maxMatches=10 winRate=0.1 seed=1"
+            << std::endl;
+  std::cerr << "  day5 ranges=40 seedRanges=10 seed=1" << std::endl;
+}
+
+int32_t main(int argc, char *argv[]) {
+  if (argc < 2) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  std::string input;
+  try {
+    Options options{parseOptions(argc, argv)};
+    input = generate(argv[1], options);
+  } catch (const std::invalid_argument &exception) {
+    std::cerr << exception.what() << std::endl;
+    printUsage(argv[0]);
+    return 1;
+  } catch (const std::exception &exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << input;
+  return 0;
+}
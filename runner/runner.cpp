@@ -0,0 +1,154 @@
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "advent_support/fileio.h"
+#include "advent_support/solver.h"
+#include "advent_support/thread_pool.h"
+
+struct Job {
+  std::string day;
+  std::string filename;
+};
+
+struct JobResult {
+  std::string output;
+  double elapsedMs;
+  bool succeeded;
+};
+
+std::vector<Job> parseManifest(const std::string &manifestFilename) {
+  /**
+   * Parse a manifest of `<day> <input path>` jobs, one per line. Blank lines
+   * and lines starting with `#` are ignored.
+   **/
+  std::vector<Job> retJobs;
+
+  int32_t lineNumber{0};
+  for (const std::string &line : readFileAsLines(manifestFilename)) {
+    lineNumber++;
+
+    std::istringstream lineStream{line};
+    Job job{};
+    if (!(lineStream >> job.day) || job.day.front() == '#') {
+      continue;
+    }
+
+    if (!(lineStream >> job.filename)) {
+      throw std::runtime_error("Malformed manifest line " +
+                               std::to_string(lineNumber) + ": " + line);
+    }
+
+    if (registeredSolvers().count(job.day) == 0) {
+      throw std::runtime_error("Unknown day on manifest line " +
+                               std::to_string(lineNumber) + ": " + job.day);
+    }
+
+    retJobs.push_back(std::move(job));
+  }
+
+  return retJobs;
+}
+
+JobResult runJob(const Job &job) {
+  const Solver &solver{registeredSolvers().at(job.day)};
+  std::ostringstream out;
+
+  const auto start{std::chrono::steady_clock::now()};
+  bool succeeded{true};
+  try {
+    solver.solve(job.filename, out);
+  } catch (const std::exception &exception) {
+    out << exception.what() << std::endl;
+    succeeded = false;
+  }
+  const auto end{std::chrono::steady_clock::now()};
+
+  return JobResult{
+      out.str(),
+      std::chrono::duration<double, std::milli>(end - start).count(),
+      succeeded,
+  };
+}
+
+void printUsage(const char *program) {
+  std::cerr << "Usage: " << program << " [-j <threads>] <manifest>"
+            << std::endl;
+  std::cerr << "Each manifest line is a `<day> <input path>` job" << std::endl;
+}
+
+int32_t main(int argc, char *argv[]) {
+  int32_t nThreads{0};
+  std::string manifestFilename;
+
+  for (int32_t i{1}; i < argc; i++) {
+    const std::string argument{argv[i]};
+    if (argument == "-j") {
+      const std::optional<int32_t> threads{
+          i + 1 < argc ? parseThreadCount(argv[++i]) : std::nullopt};
+      if (!threads) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      nThreads = *threads;
+    } else {
+      manifestFilename = argument;
+    }
+  }
+
+  if (manifestFilename.empty()) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  try {
+    const std::vector<Job> jobs{parseManifest(manifestFilename)};
+
+    // Jobs on the same input share a single read of it
+    enableFileCache();
+
+    const auto start{std::chrono::steady_clock::now()};
+
+    ThreadPool pool{nThreads};
+    std::vector<std::future<JobResult>> results;
+    results.reserve(jobs.size());
+    for (const Job &job : jobs) {
+      results.push_back(pool.submit([&job]() { return runJob(job); }));
+    }
+
+    // Report in manifest order, regardless of the completion order
+    int32_t nFailed{0};
+    double totalJobMs{0};
+    for (size_t i{0}; i < jobs.size(); i++) {
+      const JobResult result{results[i].get()};
+
+      std::cout << "== " << jobs[i].day << " " << jobs[i].filename << " ("
+                << std::fixed << std::setprecision(3) << result.elapsedMs
+                << " ms" << (result.succeeded ? "" : ", FAILED") << ") =="
+                << std::endl;
+      std::cout << result.output;
+
+      totalJobMs += result.elapsedMs;
+      nFailed += result.succeeded ? 0 : 1;
+    }
+
+    const auto end{std::chrono::steady_clock::now()};
+    std::cout << "== " << jobs.size() << " jobs on " << pool.size()
+              << " threads: " << totalJobMs << " ms of work in "
+              << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms ==" << std::endl;
+
+    return nFailed == 0 ? 0 : 1;
+  } catch (const std::exception &exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,685 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "advent_support/fileio.h"
+#include "advent_support/sha256.h"
+#include "advent_support/solver.h"
+#include "advent_support/thread_pool.h"
+#include "day5/day5.h"
+
+// Keeps every day's solver warm in one long-running process, answering
+// requests on a Unix domain socket. See the README for the protocol.
+
+// How many answers and almanacs are kept warm, each
+constexpr size_t WARM_CACHE_CAPACITY{256};
+
+// The largest inline payload accepted
+constexpr int64_t MAX_PAYLOAD_SIZE{int64_t{1} << 30};
+
+// The most received from one connection per poll, so that a large payload
+// does not hold up the other connections
+constexpr int64_t MAX_RECEIVE_PER_POLL{int64_t{1} << 20};
+
+// The longest request line accepted. A client sending a longer one is not
+// speaking the protocol, and is dropped before it fills the memory
+constexpr int64_t MAX_REQUEST_LINE_SIZE{16 * 1024};
+
+// How long a client may leave a response unread before it is dropped, so
+// that it cannot hold on to a worker
+constexpr int32_t SEND_TIMEOUT_MS{10 * 1000};
+
+std::system_error systemError(const std::string &what) {
+  return std::system_error{errno, std::generic_category(), what};
+}
+
+class FileDescriptor {
+public:
+  explicit FileDescriptor(const int32_t fd) : mFd{fd} {}
+  ~FileDescriptor() {
+    if (mFd >= 0) {
+      close(mFd);
+    }
+  }
+
+  FileDescriptor(const FileDescriptor &) = delete;
+  FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+  int32_t get() const { return mFd; }
+
+private:
+  int32_t mFd;
+};
+
+template <typename Value> class WarmCache {
+  /**
+   * Values keyed by name and version, computed at most once per version.
+   * Concurrent requests for the same value wait on the first one's load, and
+   * the least recently used values are dropped beyond `capacity`.
+   **/
+public:
+  explicit WarmCache(const size_t capacity) : mCapacity{capacity} {}
+
+  std::shared_ptr<const Value> get(const std::string &key,
+                                   const std::string &version,
+                                   const std::function<Value()> &load,
+                                   bool &retWasWarm) {
+    std::promise<std::shared_ptr<const Value>> loadPromise;
+    std::shared_future<std::shared_ptr<const Value>> value;
+
+    {
+      std::lock_guard<std::mutex> lock{mMutex};
+      auto it{mEntries.find(key)};
+
+      retWasWarm = it != mEntries.end() && it->second.version == version;
+      if (retWasWarm) {
+        value = it->second.value;
+        it->second.lastUsed = ++mClock;
+      } else {
+        value = loadPromise.get_future().share();
+        mEntries[key] = Entry{version, value, ++mClock};
+        evictLeastRecentlyUsed();
+      }
+    }
+
+    if (!retWasWarm) {
+      try {
+        loadPromise.set_value(std::make_shared<const Value>(load()));
+      } catch (...) {
+        // Do not keep failures, the input may well be fixed by the next
+        // request
+        {
+          std::lock_guard<std::mutex> lock{mMutex};
+          auto it{mEntries.find(key)};
+          if (it != mEntries.end() && it->second.version == version) {
+            mEntries.erase(it);
+          }
+        }
+        loadPromise.set_exception(std::current_exception());
+      }
+    }
+
+    return value.get();
+  }
+
+private:
+  struct Entry {
+    std::string version{};
+    std::shared_future<std::shared_ptr<const Value>> value{};
+    uint64_t lastUsed{0};
+  };
+
+  void evictLeastRecentlyUsed() {
+    while (mEntries.size() > mCapacity) {
+      mEntries.erase(std::min_element(
+          mEntries.begin(), mEntries.end(), [](const auto &a, const auto &b) {
+            return a.second.lastUsed < b.second.lastUsed;
+          }));
+    }
+  }
+
+  const size_t mCapacity;
+  std::mutex mMutex{};
+  std::map<std::string, Entry> mEntries{};
+  uint64_t mClock{0};
+};
+
+class LatencyStats {
+  /**
+   * The latency of every request, by kind of request.
+   **/
+public:
+  void record(const std::string &kind, const double elapsedMs,
+              const bool wasWarm) {
+    std::lock_guard<std::mutex> lock{mMutex};
+    Samples &samples{mSamples[kind]};
+    samples.elapsedMs.push_back(elapsedMs);
+    samples.nWarm += wasWarm ? 1 : 0;
+  }
+
+  std::string report() const {
+    std::lock_guard<std::mutex> lock{mMutex};
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+
+    for (const auto &[kind, samples] : mSamples) {
+      std::vector<double> sorted{samples.elapsedMs};
+      std::sort(sorted.begin(), sorted.end());
+      auto percentile{[&sorted](const double p) {
+        return sorted[static_cast<size_t>(p * (sorted.size() - 1))];
+      }};
+
+      out << kind << ": " << sorted.size() << " requests, " << samples.nWarm
+          << " warm, p50 " << percentile(0.5) << " ms, p99 "
+          << percentile(0.99) << " ms, max " << sorted.back() << " ms\n";
+    }
+
+    return out.str();
+  }
+
+private:
+  struct Samples {
+    std::vector<double> elapsedMs{};
+    int64_t nWarm{0};
+  };
+
+  mutable std::mutex mMutex{};
+  std::map<std::string, Samples> mSamples{};
+};
+
+struct Connection {
+  explicit Connection(const int32_t fd) : socket{fd} {}
+
+  FileDescriptor socket;
+
+  // Bytes received past the end of the last complete request
+  std::string buffered{};
+};
+
+struct Request {
+  std::string line;
+  std::string payload;
+};
+
+struct Response {
+  bool succeeded;
+  std::string body;
+};
+
+class Server {
+  /**
+   * Each request is one line, optionally followed by a payload of as many
+   * bytes as the line announces:
+   *   `solve <day> <input path>`
+   *   `solve-inline <day> <payload size>` + the input
+   *   `query <almanac path> <payload size>` + day5 queries, see `answerQueries`
+   *   `stats`
+   * and each response is `ok|error <latency in ms> <body size>\n` + the body.
+   *
+   * Answers are kept warm per input version, and the fused mapping of every
+   * almanac queried is kept warm per almanac version, so that only the first
+   * request on an input pays for the read and the parse.
+   **/
+public:
+  Server() = default;
+
+  // Answer `request`, which `connection` sent in full
+  void serve(const Connection &connection, const Request &request);
+
+private:
+  Response handle(const Request &request, std::string &retKind,
+                  bool &retWasWarm);
+
+  std::string solve(const std::string &day, const std::string &filename);
+
+  WarmCache<std::string> mAnswers{WARM_CACHE_CAPACITY};
+  WarmCache<ComposedMapping> mAlmanacs{WARM_CACHE_CAPACITY};
+  LatencyStats mLatencies{};
+  std::atomic<int64_t> mNextInlineId{0};
+};
+
+std::string fileVersion(const std::string &filename) {
+  std::error_code error;
+  const auto modified{std::filesystem::last_write_time(filename, error)};
+  const uintmax_t size{error ? 0 : std::filesystem::file_size(filename, error)};
+
+  if (error) {
+    throw std::runtime_error("Error opening file: " + filename);
+  }
+
+  return std::to_string(modified.time_since_epoch().count()) + ":" +
+         std::to_string(size);
+}
+
+bool receiveAvailable(Connection &connection) {
+  /**
+   * Append what the non-blocking `connection` has to its buffer, up to
+   * `MAX_RECEIVE_PER_POLL` bytes. Returns false once the client hung up.
+   **/
+  char chunk[64 * 1024];
+
+  for (int64_t nTotal{0}; nTotal < MAX_RECEIVE_PER_POLL;) {
+    const ssize_t nReceived{
+        recv(connection.socket.get(), chunk, sizeof(chunk), 0)};
+
+    if (nReceived == 0) {
+      return false;
+    }
+    if (nReceived < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      throw systemError("Error reading from client");
+    }
+
+    connection.buffered.append(chunk, nReceived);
+    nTotal += nReceived;
+  }
+
+  return true;
+}
+
+int64_t announcedPayloadSize(const std::string &line) {
+  // The third word of `solve-inline` and `query` requests. 0 for the other
+  // requests, and for a malformed size, which `Server::handle` reports
+  std::istringstream lineStream{line};
+  std::string kind;
+  std::string target;
+  int64_t retSize{0};
+
+  if (!(lineStream >> kind >> target) ||
+      (kind != "solve-inline" && kind != "query") ||
+      !(lineStream >> retSize) || retSize < 0 || retSize > MAX_PAYLOAD_SIZE) {
+    return 0;
+  }
+
+  return retSize;
+}
+
+std::vector<Request> takeRequests(Connection &connection) {
+  // Every request `connection` sent in full, payload included, in order
+  std::vector<Request> retRequests;
+  const std::string &buffered{connection.buffered};
+  size_t requestStart{0};
+
+  for (size_t lineEnd{buffered.find('\n')}; lineEnd != std::string::npos;
+       lineEnd = buffered.find('\n', requestStart)) {
+    // Left for `hasOverlongLine` to find
+    if (lineEnd - requestStart > MAX_REQUEST_LINE_SIZE) {
+      break;
+    }
+
+    std::string line{buffered.substr(requestStart, lineEnd - requestStart)};
+    const size_t payloadSize{
+        static_cast<size_t>(announcedPayloadSize(line))};
+    if (buffered.size() - (lineEnd + 1) < payloadSize) {
+      break;
+    }
+
+    retRequests.push_back(
+        Request{std::move(line), buffered.substr(lineEnd + 1, payloadSize)});
+    requestStart = lineEnd + 1 + payloadSize;
+  }
+
+  connection.buffered.erase(0, requestStart);
+  return retRequests;
+}
+
+bool hasOverlongLine(const Connection &connection) {
+  // Whether the request line at the start of the buffer, complete or not, is
+  // longer than `MAX_REQUEST_LINE_SIZE`
+  const std::string &buffered{connection.buffered};
+  return std::min(buffered.find('\n'), buffered.size()) >
+         static_cast<size_t>(MAX_REQUEST_LINE_SIZE);
+}
+
+void sendAll(const Connection &connection, std::string_view data) {
+  // The socket is non-blocking, a client slow to read is waited on here, for
+  // up to `SEND_TIMEOUT_MS` without progress
+  while (!data.empty()) {
+    const ssize_t nSent{send(connection.socket.get(), data.data(), data.size(),
+                             MSG_NOSIGNAL)};
+    if (nSent < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        pollfd writable{connection.socket.get(), POLLOUT, 0};
+        const int32_t nReady{poll(&writable, 1, SEND_TIMEOUT_MS)};
+        if (nReady == 0) {
+          throw std::runtime_error("Timed out writing to client");
+        }
+        if (nReady < 0 && errno != EINTR) {
+          throw systemError("Error waiting on client");
+        }
+        continue;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      throw systemError("Error writing to client");
+    }
+    data.remove_prefix(nSent);
+  }
+}
+
+std::string Server::solve(const std::string &day, const std::string &filename) {
+  const Solver &solver{registeredSolvers().at(day)};
+  std::ostringstream out;
+  solver.solve(filename, out);
+  return out.str();
+}
+
+Response Server::handle(const Request &request, std::string &retKind,
+                        bool &retWasWarm) {
+  const std::string &line{request.line};
+  std::istringstream lineStream{line};
+  lineStream >> retKind;
+
+  if (retKind == "stats") {
+    return Response{true, mLatencies.report()};
+  }
+
+  std::string target;
+  if (!(lineStream >> target)) {
+    throw std::runtime_error("Malformed request: " + line);
+  }
+
+  if (retKind == "solve") {
+    std::string filename;
+    if (!(lineStream >> filename)) {
+      throw std::runtime_error("Malformed request: " + line);
+    }
+    if (registeredSolvers().count(target) == 0) {
+      throw std::runtime_error("Unknown day: " + target);
+    }
+
+    const auto answer{
+        mAnswers.get(target + " " + filename, fileVersion(filename),
+                     [&]() { return solve(target, filename); }, retWasWarm)};
+    return Response{true, *answer};
+  }
+
+  int64_t payloadSize{-1};
+  if (!(lineStream >> payloadSize)) {
+    throw std::runtime_error("Malformed request: " + line);
+  }
+  if (payloadSize < 0 || payloadSize > MAX_PAYLOAD_SIZE) {
+    throw std::runtime_error("Malformed payload size");
+  }
+  const std::string &payload{request.payload};
+
+  if (retKind == "solve-inline") {
+    if (registeredSolvers().count(target) == 0) {
+      throw std::runtime_error("Unknown day: " + target);
+    }
+
+    // Keyed by the payload's SHA-256 digest, which never names another
+    // payload, so it needs no version. The solvers read their input by name,
+    // and are served the payload from the file cache under a name no other
+    // request uses
+    const auto answer{mAnswers.get(
+        target + " inline " + sha256(payload), "",
+        [&]() {
+          const std::string filename{"inline:" +
+                                     std::to_string(mNextInlineId++)};
+          pinFileContents(filename, payload);
+          try {
+            std::string retAnswer{solve(target, filename)};
+            evictFile(filename);
+            return retAnswer;
+          } catch (...) {
+            evictFile(filename);
+            throw;
+          }
+        },
+        retWasWarm)};
+    return Response{true, *answer};
+  }
+
+  if (retKind == "query") {
+    const auto composed{mAlmanacs.get(
+        target, fileVersion(target),
+        [&target]() { return day5::composeAlmanac(target); },
+        retWasWarm)};
+    return Response{true, day5::answerQueries(*composed, payload)};
+  }
+
+  throw std::runtime_error("Unknown request: " + retKind);
+}
+
+void Server::serve(const Connection &connection, const Request &request) {
+  const auto start{std::chrono::steady_clock::now()};
+  std::string kind;
+  bool wasWarm{false};
+  Response response{};
+  try {
+    response = handle(request, kind, wasWarm);
+  } catch (const std::exception &exception) {
+    response = Response{false, std::string{exception.what()} + "\n"};
+  }
+  const auto end{std::chrono::steady_clock::now()};
+  const double elapsedMs{
+      std::chrono::duration<double, std::milli>(end - start).count()};
+
+  if (kind == "solve" || kind == "solve-inline" || kind == "query") {
+    mLatencies.record(kind, elapsedMs, wasWarm);
+  } else if (kind != "stats") {
+    mLatencies.record("invalid", elapsedMs, false);
+  }
+
+  std::ostringstream header;
+  header << (response.succeeded ? "ok " : "error ") << std::fixed
+         << std::setprecision(3) << elapsedMs << " " << response.body.size()
+         << "\n";
+  sendAll(connection, header.str() + response.body);
+}
+
+// Written to by the signal handler to wake up the accept loop
+int32_t wakeUpFd{-1};
+volatile std::sig_atomic_t stopRequested{0};
+
+void requestStop(int32_t) {
+  stopRequested = 1;
+  const char byte{0};
+  [[maybe_unused]] const ssize_t nWritten{write(wakeUpFd, &byte, 1)};
+}
+
+int32_t listenOn(const std::string &socketPath) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Socket path too long: " + socketPath);
+  }
+  std::strcpy(address.sun_path, socketPath.c_str());
+
+  // A socket left behind by a previous server that did not shut down cleanly
+  struct stat status{};
+  if (lstat(socketPath.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+    unlink(socketPath.c_str());
+  }
+
+  const int32_t fd{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+  if (fd < 0) {
+    throw systemError("Error creating socket");
+  }
+  if (bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) <
+          0 ||
+      listen(fd, SOMAXCONN) < 0) {
+    const std::system_error error{systemError("Error listening on " +
+                                              socketPath)};
+    close(fd);
+    throw error;
+  }
+
+  return fd;
+}
+
+void runServer(const std::string &socketPath, const int32_t nThreads) {
+  /**
+   * The main thread polls the listening socket and every idle connection,
+   * and receives whatever they sent. Only the requests received in full are
+   * handed to the pool, so that no worker waits on a client. A worker
+   * answers them in order, then returns the connection to the idle set and
+   * wakes up the main thread to poll it again.
+   **/
+  int32_t wakeUpPipe[2];
+  if (pipe2(wakeUpPipe, O_CLOEXEC | O_NONBLOCK) < 0) {
+    throw systemError("Error creating pipe");
+  }
+  const FileDescriptor wakeUpRead{wakeUpPipe[0]};
+  const FileDescriptor wakeUpWrite{wakeUpPipe[1]};
+  wakeUpFd = wakeUpWrite.get();
+
+  std::signal(SIGINT, requestStop);
+  std::signal(SIGTERM, requestStop);
+
+  const FileDescriptor listener{listenOn(socketPath)};
+  std::cerr << "Listening on " << socketPath << std::endl;
+
+  Server server;
+  std::mutex idleMutex;
+  std::vector<std::shared_ptr<Connection>> idle;
+  std::vector<std::shared_ptr<Connection>> returned;
+
+  {
+    ThreadPool pool{nThreads};
+
+    while (stopRequested == 0) {
+      std::vector<pollfd> polled{{wakeUpRead.get(), POLLIN, 0},
+                                 {listener.get(), POLLIN, 0}};
+      for (const auto &connection : idle) {
+        polled.push_back({connection->socket.get(), POLLIN, 0});
+      }
+
+      if (poll(polled.data(), polled.size(), -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw systemError("Error polling sockets");
+      }
+
+      if (polled[0].revents != 0) {
+        char drained[64];
+        while (read(wakeUpRead.get(), drained, sizeof(drained)) > 0) {
+        }
+      }
+
+      if (polled[1].revents != 0) {
+        const int32_t fd{accept4(listener.get(), nullptr, nullptr,
+                                 SOCK_CLOEXEC | SOCK_NONBLOCK)};
+        if (fd >= 0) {
+          idle.push_back(std::make_shared<Connection>(fd));
+        }
+      }
+
+      // A connection stays idle until one of its requests is complete. One
+      // that hung up is closed once its last requests are answered
+      std::vector<std::shared_ptr<Connection>> stillIdle;
+      for (size_t i{0}; i < idle.size(); i++) {
+        if (polled.size() <= i + 2 || polled[i + 2].revents == 0) {
+          stillIdle.push_back(std::move(idle[i]));
+          continue;
+        }
+
+        bool isOpen{false};
+        try {
+          isOpen = receiveAvailable(*idle[i]);
+        } catch (const std::exception &exception) {
+          std::cerr << exception.what() << std::endl;
+        }
+
+        std::vector<Request> requests{takeRequests(*idle[i])};
+        if (hasOverlongLine(*idle[i])) {
+          std::cerr << "Dropping a client whose request line is longer than "
+                    << MAX_REQUEST_LINE_SIZE << " bytes" << std::endl;
+          isOpen = false;
+        }
+        if (requests.empty()) {
+          if (isOpen) {
+            stillIdle.push_back(std::move(idle[i]));
+          }
+          continue;
+        }
+
+        pool.submit([connection{std::move(idle[i])},
+                     requests{std::move(requests)}, isOpen, &server,
+                     &idleMutex, &returned, &wakeUpWrite]() mutable {
+          try {
+            for (const Request &request : requests) {
+              server.serve(*connection, request);
+            }
+          } catch (const std::exception &exception) {
+            std::cerr << exception.what() << std::endl;
+            isOpen = false;
+          }
+
+          if (isOpen) {
+            std::lock_guard<std::mutex> lock{idleMutex};
+            returned.push_back(connection);
+          }
+          const char byte{0};
+          [[maybe_unused]] const ssize_t nWritten{
+              write(wakeUpWrite.get(), &byte, 1)};
+        });
+      }
+      idle = std::move(stillIdle);
+
+      std::lock_guard<std::mutex> lock{idleMutex};
+      for (auto &connection : returned) {
+        idle.push_back(std::move(connection));
+      }
+      returned.clear();
+    }
+
+    // Leaving the scope waits on the requests in flight
+  }
+
+  unlink(socketPath.c_str());
+  std::cerr << "Stopped" << std::endl;
+}
+
+void printUsage(const char *program) {
+  std::cerr << "Usage: " << program << " [-j <threads>] [<socket path>]"
+            << std::endl;
+}
+
+int32_t main(int argc, char *argv[]) {
+  int32_t nThreads{0};
+  std::string socketPath{"advent.sock"};
+
+  for (int32_t i{1}; i < argc; i++) {
+    const std::string argument{argv[i]};
+    if (argument == "-j") {
+      const std::optional<int32_t> threads{
+          i + 1 < argc ? parseThreadCount(argv[++i]) : std::nullopt};
+      if (!threads) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      nThreads = *threads;
+    } else if (argument.empty() || argument.front() == '-') {
+      printUsage(argv[0]);
+      return 1;
+    } else {
+      socketPath = argument;
+    }
+  }
+
+  try {
+    // Requests on the same input share a single read of it, for as long as
+    // it does not change
+    enableFileCache();
+    runServer(socketPath, nThreads);
+    return 0;
+  } catch (const std::exception &exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "day5/composed_mapping.h"
+#include "day5/range_mapping.h"
+#include "test.h"
+
+// `ComposedMapping` answers the same as walking its `RangeMapping`s one at a
+// time does
+
+namespace {
+
+// Random mappings over [0, span) whose sources do not overlap but whose
+// destinations do, so that many seeds share a location
+std::vector<RangeMapping> randomMappings(const int64_t nMappings,
+                                         const int64_t span,
+                                         std::mt19937_64 &random) {
+  std::vector<RangeMapping> retMappings(nMappings);
+  for (RangeMapping &mapping : retMappings) {
+    for (int64_t start{static_cast<int64_t>(random() % 8)}; start < span;) {
+      const int64_t length{1 + static_cast<int64_t>(random() % 40)};
+      const int64_t destination{static_cast<int64_t>(random() % span)};
+      mapping.addRange(start, destination, length);
+      start += length + static_cast<int64_t>(random() % 30);
+    }
+    mapping.sortRanges();
+  }
+  return retMappings;
+}
+
+int64_t referenceMap(const std::vector<RangeMapping> &mappings,
+                     int64_t value) {
+  for (const RangeMapping &mapping : mappings) {
+    for (const auto &[source, destination, length] : mapping.ranges()) {
+      if (value >= source && value < source + length) {
+        value += destination - source;
+        break;
+      }
+    }
+  }
+  return value;
+}
+
+// Every seed mapping to `location`, inverting one mapping at a time
+std::vector<int64_t> referenceUnmap(const std::vector<RangeMapping> &mappings,
+                                    const int64_t location) {
+  std::set<int64_t> values{location};
+  for (auto mapping{mappings.rbegin()}; mapping != mappings.rend(); mapping++) {
+    std::set<int64_t> preimages;
+    for (const int64_t value : values) {
+      bool isMapped{false};
+      for (const auto &[source, destination, length] : mapping->ranges()) {
+        if (value >= destination && value < destination + length) {
+          preimages.insert(value - destination + source);
+        }
+        isMapped = isMapped || (value >= source && value < source + length);
+      }
+      if (!isMapped) {
+        preimages.insert(value);
+      }
+    }
+    values = std::move(preimages);
+  }
+  return {values.begin(), values.end()};
+}
+
+TEST(composedMappingMapsLikeItsMappings) {
+  std::mt19937_64 random{31};
+  for (int64_t round{0}; round < 20; round++) {
+    const std::vector<RangeMapping> mappings{
+        randomMappings(1 + round % 7, 600, random)};
+    const ComposedMapping composed{mappings};
+    for (int64_t value{0}; value < 700; value++) {
+      CHECK_EQUAL(composed.mapValue(value), referenceMap(mappings, value));
+    }
+  }
+}
+
+TEST(composedMappingUnmapsOverlappingImages) {
+  std::mt19937_64 random{3131};
+  int64_t nShared{0};
+  for (int64_t round{0}; round < 20; round++) {
+    const std::vector<RangeMapping> mappings{
+        randomMappings(1 + round % 7, 600, random)};
+    const ComposedMapping composed{mappings};
+    for (int64_t location{-2}; location < 700; location++) {
+      const std::vector<int64_t> seeds{composed.unmapValue(location)};
+      CHECK(seeds == referenceUnmap(mappings, location));
+      nShared += seeds.size() > 1 ? 1 : 0;
+    }
+  }
+  // The images overlap often enough for the test to mean something
+  CHECK(nShared > 1000);
+}
+
+} // namespace
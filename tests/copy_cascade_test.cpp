@@ -0,0 +1,78 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "advent_support/thread_pool.h"
+#include "day4/copy_cascade.h"
+#include "test.h"
+
+// The blocked, parallel copy cascade counts the same copies as handing them
+// out one card at a time does, however the deck is split into blocks
+
+namespace {
+
+uint64_t referenceCopies(const std::vector<int32_t> &nMatches) {
+  const int64_t nCards{static_cast<int64_t>(nMatches.size())};
+  std::vector<uint64_t> copies(nCards, 1);
+  uint64_t retTotal{0};
+
+  for (int64_t card{0}; card < nCards; card++) {
+    retTotal += copies[card];
+    // A card whose copies would run past the last card wins none
+    if (card + nMatches[card] >= nCards) {
+      continue;
+    }
+    for (int64_t next{card + 1}; next <= card + nMatches[card]; next++) {
+      copies[next] += copies[card];
+    }
+  }
+
+  return retTotal;
+}
+
+std::vector<int32_t> randomMatches(int64_t nCards, int32_t maxMatches,
+                                   std::mt19937_64 &random) {
+  std::vector<int32_t> retMatches(nCards);
+  for (int32_t &matches : retMatches) {
+    // Mostly small counts, so that the copies grow slowly
+    matches = random() % 4 == 0
+                  ? static_cast<int32_t>(random() % (maxMatches + 1))
+                  : static_cast<int32_t>(random() % 2);
+  }
+  return retMatches;
+}
+
+TEST(copyCascadeMatchesReference) {
+  std::mt19937_64 random{34};
+  ThreadPool pool2{2};
+  ThreadPool pool5{5};
+
+  // Around the 16k cards of the smallest block, and across many blocks
+  for (const int64_t nCards :
+       {int64_t{0}, int64_t{1}, int64_t{7}, int64_t{16 * 1024 - 1},
+        int64_t{16 * 1024 + 1}, int64_t{3 * 16 * 1024}, int64_t{200001}}) {
+    for (const int32_t maxMatches : {0, 1, 3, 10, 25}) {
+      const std::vector<int32_t> nMatches{
+          randomMatches(nCards, maxMatches, random)};
+      const uint64_t expected{referenceCopies(nMatches)};
+
+      CHECK_EQUAL(countCardCopies(nMatches), expected);
+      CHECK_EQUAL(countCardCopies(nMatches, &pool2), expected);
+      CHECK_EQUAL(countCardCopies(nMatches, &pool5), expected);
+    }
+  }
+}
+
+TEST(copyCascadeWrapsAround) {
+  // Every card winning the next two makes Fibonacci numbers of copies,
+  // which overflow 64 bits long before the end of the deck
+  ThreadPool pool{3};
+  std::vector<int32_t> nMatches(100000, 2);
+  nMatches[50000] = 7;
+
+  const uint64_t expected{referenceCopies(nMatches)};
+  CHECK_EQUAL(countCardCopies(nMatches), expected);
+  CHECK_EQUAL(countCardCopies(nMatches, &pool), expected);
+}
+
+} // namespace
@@ -0,0 +1,223 @@
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "advent_support/cpu_dispatch.h"
+#include "test.h"
+
+// Every kernel answers the same as a plain loop over its input does, on
+// random inputs of every length around the kernels' vector widths and chunk
+// sizes. The kernels run at the level `ADVENT_CPU_LEVEL` allows, which is
+// fixed for the process, so `make test` runs these tests once per level
+
+namespace {
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Random text out of digits, spelled digits and their prefixes, letters,
+// spaces and bytes past ASCII
+std::string randomText(int64_t size, std::mt19937_64 &random) {
+  constexpr std::string_view PIECES[]{
+      "one", "two", "three", "four",  "five",   "six", "seven", "eight",
+      "nine", "on", "tw",    "thre",  "eigh",   "nin", "oneight", "x",
+      "e",    "n",  " ",     "\xc3\xa9", "\xff"};
+  std::string retText;
+  while (static_cast<int64_t>(retText.size()) < size) {
+    if (random() % 4 == 0) {
+      retText.push_back(static_cast<char>('0' + random() % 10));
+    } else {
+      retText.append(PIECES[random() % std::size(PIECES)]);
+    }
+  }
+  retText.resize(size);
+  return retText;
+}
+
+// Text whose digit density varies from none to all
+std::string randomDigits(int64_t size, std::mt19937_64 &random) {
+  const uint64_t density{random() % 5};
+  std::string retText(size, '.');
+  for (char &c : retText) {
+    if (random() % 4 < density) {
+      c = static_cast<char>('0' + random() % 10);
+    } else if (random() % 2 == 0) {
+      // Just outside the digits
+      c = random() % 2 == 0 ? '/' : ':';
+    }
+  }
+  return retText;
+}
+
+// Lengths that hit every tail of the 16, 32 and 64 byte vectors and of the
+// 64 column transpose chunks, and some longer ones
+int64_t randomLength(std::mt19937_64 &random) {
+  return random() % 3 == 0 ? static_cast<int64_t>(random() % 300)
+                           : static_cast<int64_t>(random() % 140);
+}
+
+TEST(cpuFindDigitBoundsMatchesScalar) {
+  std::mt19937_64 random{45};
+  for (int64_t round{0}; round < 3000; round++) {
+    const std::string text{randomDigits(randomLength(random), random)};
+
+    DigitBounds expected{-1, -1};
+    for (int64_t i{0}; i < static_cast<int64_t>(text.size()); i++) {
+      if (isDigit(text[i])) {
+        expected.first = expected.first < 0 ? i : expected.first;
+        expected.last = i;
+      }
+    }
+
+    const DigitBounds bounds{findDigitBounds(text.data(), text.size())};
+    CHECK_EQUAL(bounds.first, expected.first);
+    CHECK_EQUAL(bounds.last, expected.last);
+  }
+}
+
+TEST(cpuFindSpelledDigitsMatchesScalar) {
+  constexpr std::string_view WORDS[]{"one", "two",   "three", "four", "five",
+                                     "six", "seven", "eight", "nine"};
+  std::mt19937_64 random{4545};
+
+  for (int64_t round{0}; round < 300; round++) {
+    // Ragged batches of every size, with lines longer than a chunk
+    const int32_t nLines{
+        1 + static_cast<int32_t>(random() % SPELLED_DIGIT_BATCH)};
+    std::vector<std::string> texts;
+    for (int32_t i{0}; i < nLines; i++) {
+      texts.push_back(randomText(randomLength(random), random));
+    }
+    const std::vector<std::string_view> lines(texts.begin(), texts.end());
+
+    std::vector<int8_t> first(nLines);
+    std::vector<int8_t> last(nLines);
+    findSpelledDigits(lines.data(), nLines, first.data(), last.data());
+
+    for (int32_t i{0}; i < nLines; i++) {
+      const std::string_view line{lines[i]};
+      std::vector<int32_t> digits;
+      for (size_t column{0}; column < line.size(); column++) {
+        if (isDigit(line[column])) {
+          digits.push_back(line[column] - '0');
+        }
+        for (int32_t word{0}; word < 9; word++) {
+          if (line.substr(column).starts_with(WORDS[word])) {
+            digits.push_back(word + 1);
+          }
+        }
+      }
+
+      CHECK_EQUAL(int32_t{first[i]}, digits.empty() ? -1 : digits.front());
+      CHECK_EQUAL(int32_t{last[i]}, digits.empty() ? -1 : digits.back());
+    }
+  }
+}
+
+TEST(cpuDecodeNumbersMatchesScalar) {
+  std::mt19937_64 random{454545};
+  for (int64_t round{0}; round < 3000; round++) {
+    // Numbers of at most 9 digits, so that they fit
+    std::string text{randomDigits(randomLength(random), random)};
+    for (size_t i{9}; i < text.size(); i += 10) {
+      text[i] = ' ';
+    }
+
+    std::vector<int32_t> expected;
+    for (size_t i{0}; i < text.size();) {
+      if (!isDigit(text[i])) {
+        i++;
+        continue;
+      }
+      int32_t value{0};
+      for (; i < text.size() && isDigit(text[i]); i++) {
+        value = value * 10 + (text[i] - '0');
+      }
+      expected.push_back(value);
+    }
+
+    // Room for all of them, or for only some of them
+    const int64_t capacity{static_cast<int64_t>(
+        random() % 2 == 0 ? expected.size()
+                          : random() % (expected.size() + 1))};
+    std::vector<int32_t> numbers(capacity + 1, -1);
+    const int64_t nNumbers{
+        decodeNumbers(text.data(), text.size(), numbers.data(), capacity)};
+
+    CHECK_EQUAL(nNumbers, static_cast<int64_t>(expected.size()));
+    for (int64_t i{0}; i < capacity; i++) {
+      CHECK_EQUAL(numbers[i], expected[i]);
+    }
+    CHECK_EQUAL(numbers[capacity], -1);
+  }
+}
+
+TEST(cpuFindContainingRangeMatchesScalar) {
+  std::mt19937_64 random{45454545};
+  for (int64_t round{0}; round < 3000; round++) {
+    // Overlapping ranges, some of them empty, near both ends of int64_t
+    const int64_t n{randomLength(random) / 2};
+    const int64_t base{random() % 3 == 0
+                           ? std::numeric_limits<int64_t>::min() + 100
+                       : random() % 2 == 0
+                           ? std::numeric_limits<int64_t>::max() - 300
+                           : -100};
+    std::vector<int64_t> starts(n);
+    std::vector<int64_t> ends(n);
+    for (int64_t i{0}; i < n; i++) {
+      starts[i] = base + static_cast<int64_t>(random() % 200);
+      ends[i] = starts[i] + static_cast<int64_t>(random() % 40);
+    }
+
+    for (int64_t value{base - 5}; value < base + 250; value += 7) {
+      int64_t expected{n};
+      for (int64_t i{n - 1}; i >= 0; i--) {
+        expected = value >= starts[i] && value < ends[i] ? i : expected;
+      }
+      CHECK_EQUAL(findContainingRange(starts.data(), ends.data(), n, value),
+                  expected);
+    }
+  }
+}
+
+TEST(cpuSumWithinLimitsMatchesScalar) {
+  std::mt19937_64 random{4545454545};
+  for (int64_t round{0}; round < 3000; round++) {
+    const int64_t n{randomLength(random)};
+    std::vector<int32_t> x(n);
+    std::vector<int32_t> y(n);
+    std::vector<int32_t> z(n);
+    std::vector<int64_t> first(n);
+    std::vector<int64_t> second(n);
+    for (int64_t i{0}; i < n; i++) {
+      x[i] = static_cast<int32_t>(random() % 20) - 2;
+      y[i] = static_cast<int32_t>(random() % 20) - 2;
+      z[i] = static_cast<int32_t>(random() % 20) - 2;
+      first[i] = static_cast<int64_t>(random() % 1000000) - 1000;
+      second[i] = static_cast<int64_t>(random());
+    }
+    const int32_t xLimit{static_cast<int32_t>(random() % 24) - 4};
+    const int32_t yLimit{static_cast<int32_t>(random() % 24) - 4};
+    const int32_t zLimit{static_cast<int32_t>(random() % 24) - 4};
+
+    int64_t expectedFirst{0};
+    uint64_t expectedSecond{0};
+    for (int64_t i{0}; i < n; i++) {
+      if (x[i] <= xLimit && y[i] <= yLimit && z[i] <= zLimit) {
+        expectedFirst += first[i];
+        // Wraps around, where the kernels' int64_t sums do too
+        expectedSecond += static_cast<uint64_t>(second[i]);
+      }
+    }
+
+    const MaskedSums sums{sumWithinLimits(x.data(), y.data(), z.data(),
+                                          first.data(), second.data(), n,
+                                          xLimit, yLimit, zLimit)};
+    CHECK_EQUAL(sums.first, expectedFirst);
+    CHECK_EQUAL(static_cast<uint64_t>(sums.second), expectedSecond);
+  }
+}
+
+} // namespace
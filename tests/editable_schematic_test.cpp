@@ -0,0 +1,112 @@
+#include <cctype>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "day3/editable_schematic.h"
+#include "test.h"
+
+// `EditableSchematic` keeps its sums the same as recomputing them from the
+// edited grid does, through any sequence of edits
+
+namespace {
+
+bool isDigit(char c) { return std::isdigit(static_cast<unsigned char>(c)); }
+
+// The (part number sum, gear ratio sum) of `grid`, from scratch
+std::pair<int64_t, int64_t>
+referenceSums(const std::vector<std::string> &grid) {
+  const int64_t height{static_cast<int64_t>(grid.size())};
+  auto at{[&grid, height](int64_t row, int64_t column) {
+    if (row < 0 || row >= height || column < 0 ||
+        column >= static_cast<int64_t>(grid[row].size())) {
+      return '.';
+    }
+    return grid[row][column];
+  }};
+
+  int64_t partSum{0};
+  std::map<std::pair<int64_t, int64_t>, std::vector<int64_t>> gearNumbers;
+  for (int64_t row{0}; row < height; row++) {
+    const int64_t width{static_cast<int64_t>(grid[row].size())};
+    for (int64_t column{0}; column < width; column++) {
+      if (!isDigit(grid[row][column])) {
+        continue;
+      }
+      int64_t end{column};
+      while (end < width && isDigit(grid[row][end])) {
+        end++;
+      }
+      const int64_t value{std::stoll(grid[row].substr(column, end - column))};
+
+      bool touchesSymbol{false};
+      for (int64_t r{row - 1}; r <= row + 1; r++) {
+        for (int64_t c{column - 1}; c <= end; c++) {
+          const char cell{at(r, c)};
+          touchesSymbol = touchesSymbol || (cell != '.' && !isDigit(cell));
+          if (cell == '*') {
+            gearNumbers[{r, c}].push_back(value);
+          }
+        }
+      }
+      partSum += touchesSymbol ? value : 0;
+      column = end;
+    }
+  }
+
+  int64_t gearSum{0};
+  for (const auto &[gear, numbers] : gearNumbers) {
+    gearSum += numbers.size() == 2 ? numbers[0] * numbers[1] : 0;
+  }
+  return {partSum, gearSum};
+}
+
+char randomCell(std::mt19937_64 &random) {
+  // Mostly digits and blanks, so that numbers grow, merge and split
+  constexpr std::string_view CELLS{"0123456789......*#*+"};
+  return CELLS[random() % CELLS.size()];
+}
+
+TEST(editableSchematicMatchesReference) {
+  std::mt19937_64 random{42};
+
+  for (int64_t round{0}; round < 30; round++) {
+    // Ragged rows, at most 12 cells wide so that every number fits
+    std::vector<std::string> grid(1 + random() % 10);
+    for (std::string &row : grid) {
+      row.resize(random() % 13);
+      for (char &cell : row) {
+        cell = randomCell(random);
+      }
+    }
+
+    std::string contents;
+    for (const std::string &row : grid) {
+      contents += row + "\n";
+    }
+    EditableSchematic schematic{contents};
+    CHECK(std::make_pair(schematic.partNumberSum(),
+                         schematic.gearRatioSum()) == referenceSums(grid));
+
+    for (int64_t edit{0}; edit < 300; edit++) {
+      const int32_t row{static_cast<int32_t>(random() % grid.size())};
+      if (grid[row].empty()) {
+        continue;
+      }
+      const int32_t column{static_cast<int32_t>(random() % grid[row].size())};
+      const char value{randomCell(random)};
+
+      schematic.setCell(row, column, value);
+      grid[row][column] = value;
+      CHECK_EQUAL(schematic.cell(row, column), value);
+      CHECK(std::make_pair(schematic.partNumberSum(),
+                           schematic.gearRatioSum()) == referenceSums(grid));
+    }
+  }
+}
+
+} // namespace
@@ -0,0 +1,109 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "day2/game_store.h"
+#include "test.h"
+
+// The columnar game store, its batches and its dominance index answer limit
+// queries the same as checking every game against them does
+
+namespace {
+
+struct Game {
+  int64_t id;
+  int32_t red;
+  int32_t green;
+  int32_t blue;
+};
+
+LimitAnswer referenceEvaluate(const std::vector<Game> &games,
+                              const BagLimits &limits) {
+  LimitAnswer retAnswer{0, 0};
+  for (const Game &game : games) {
+    if (game.red <= limits.red && game.green <= limits.green &&
+        game.blue <= limits.blue) {
+      retAnswer.idsSum += game.id;
+      retAnswer.powersSum += int64_t{game.red} * game.green * game.blue;
+    }
+  }
+  return retAnswer;
+}
+
+bool operator==(const LimitAnswer &a, const LimitAnswer &b) {
+  return a.idsSum == b.idsSum && a.powersSum == b.powersSum;
+}
+
+// Random games with counts in [0, maxCount], and one query per possible
+// combination of limits in [-1, maxCount + 1] when there are few enough of
+// them, random ones otherwise
+void checkStore(int64_t nGames, int32_t maxCount, std::mt19937_64 &random) {
+  auto randomCount{[&random](int32_t max) {
+    return static_cast<int32_t>(random() % (max + 1));
+  }};
+
+  GameStore store;
+  std::vector<Game> games;
+  int64_t powersSum{0};
+  for (int64_t id{1}; id <= nGames; id++) {
+    const Game game{id, randomCount(maxCount), randomCount(maxCount),
+                    randomCount(maxCount)};
+    store.addGame(game.id, game.red, game.green, game.blue);
+    games.push_back(game);
+    powersSum += int64_t{game.red} * game.green * game.blue;
+  }
+  CHECK_EQUAL(store.powersSum(), powersSum);
+
+  std::vector<BagLimits> queries;
+  if (maxCount <= 12) {
+    for (int32_t red{-1}; red <= maxCount + 1; red++) {
+      for (int32_t green{-1}; green <= maxCount + 1; green++) {
+        for (int32_t blue{-1}; blue <= maxCount + 1; blue++) {
+          queries.push_back({red, green, blue});
+        }
+      }
+    }
+  } else {
+    for (int64_t i{0}; i < 300; i++) {
+      queries.push_back({randomCount(maxCount + 1), randomCount(maxCount + 1),
+                         randomCount(maxCount + 1)});
+    }
+  }
+
+  const std::vector<LimitAnswer> batch{store.evaluateBatch(queries)};
+  CHECK_EQUAL(batch.size(), queries.size());
+  const bool indexFits{DominanceIndex::nCells(store) <=
+                       DominanceIndex::MAX_CELLS};
+  for (size_t i{0}; i < queries.size(); i++) {
+    const LimitAnswer expected{referenceEvaluate(games, queries[i])};
+    CHECK(store.evaluate(queries[i]) == expected);
+    CHECK(batch[i] == expected);
+  }
+
+  if (indexFits) {
+    const DominanceIndex index{store};
+    for (const BagLimits &limits : queries) {
+      CHECK(index.evaluate(limits) == referenceEvaluate(games, limits));
+    }
+  }
+}
+
+TEST(gameStoreMatchesReference) {
+  std::mt19937_64 random{41};
+
+  // Every length around the vector widths, then larger stores
+  for (int64_t nGames{0}; nGames <= 33; nGames++) {
+    checkStore(nGames, 6, random);
+  }
+  checkStore(1000, 12, random);
+  checkStore(5000, 20, random);
+}
+
+TEST(gameStoreBatchesWithoutIndex) {
+  // Too many distinct counts for a dominance index, so batches are scanned
+  std::mt19937_64 random{4141};
+  checkStore(3000, 1000000, random);
+  checkStore(3000, 1000000, random);
+}
+
+} // namespace
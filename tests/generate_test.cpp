@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "advent_support/input_generators.h"
+#include "advent_support/solver.h"
+#include "test.h"
+
+// Every day solves the inputs of its generator the same as a naive reference
+// solution, written straight from the puzzle statement, does
+
+namespace {
+
+std::vector<std::string> splitLines(const std::string &input) {
+  std::vector<std::string> retLines;
+  std::istringstream stream{input};
+  for (std::string line; std::getline(stream, line);) {
+    retLines.push_back(line);
+  }
+  return retLines;
+}
+
+std::vector<int64_t> numbersIn(const std::string &text) {
+  std::vector<int64_t> retNumbers;
+  std::istringstream stream{text};
+  for (int64_t number{0}; stream >> number;) {
+    retNumbers.push_back(number);
+  }
+  return retNumbers;
+}
+
+std::string solve(const std::string &day, const std::string &input) {
+  const TemporaryDirectory directory;
+  std::ostringstream out;
+  registeredSolvers().at(day).solve(directory.write("input.txt", input), out);
+  return out.str();
+}
+
+std::string referenceDay1(const std::string &input) {
+  constexpr std::string_view WORDS[]{"one", "two",   "three", "four", "five",
+                                     "six", "seven", "eight", "nine"};
+  int64_t sumA{0};
+  int64_t sumB{0};
+
+  for (const std::string &line : splitLines(input)) {
+    std::vector<int64_t> digits;
+    std::vector<int64_t> spelled;
+    for (size_t i{0}; i < line.size(); i++) {
+      if (std::isdigit(static_cast<unsigned char>(line[i]))) {
+        digits.push_back(line[i] - '0');
+        spelled.push_back(line[i] - '0');
+      }
+      for (int64_t word{0}; word < 9; word++) {
+        if (std::string_view{line}.substr(i).starts_with(WORDS[word])) {
+          spelled.push_back(word + 1);
+        }
+      }
+    }
+    sumA += 10 * digits.front() + digits.back();
+    sumB += 10 * spelled.front() + spelled.back();
+  }
+
+  return "Part A: The calibration value is: " + std::to_string(sumA) +
+         "\nPart B: The calibration value is: " + std::to_string(sumB) + "\n";
+}
+
+std::string referenceDay2(const std::string &input) {
+  int64_t idsSum{0};
+  int64_t powersSum{0};
+
+  for (const std::string &line : splitLines(input)) {
+    std::istringstream stream{line.substr(line.find(':') + 1)};
+    int64_t red{0};
+    int64_t green{0};
+    int64_t blue{0};
+    int64_t count{0};
+    std::string color;
+    while (stream >> count >> color) {
+      color.erase(color.find_last_not_of(",;") + 1);
+      int64_t &largest{color == "red" ? red : color == "green" ? green : blue};
+      largest = std::max(largest, count);
+    }
+
+    if (red <= 12 && green <= 13 && blue <= 14) {
+      idsSum += numbersIn(line.substr(5, line.find(':') - 5)).front();
+    }
+    powersSum += red * green * blue;
+  }
+
+  return "Part A: The possible games sum is: " + std::to_string(idsSum) +
+         "\nPart B: The powers sum is: " + std::to_string(powersSum) + "\n";
+}
+
+std::string referenceDay3(const std::string &input) {
+  const std::vector<std::string> grid{splitLines(input)};
+  const int64_t height{static_cast<int64_t>(grid.size())};
+  auto at{[&grid, height](int64_t row, int64_t column) {
+    if (row < 0 || row >= height || column < 0 ||
+        column >= static_cast<int64_t>(grid[row].size())) {
+      return '.';
+    }
+    return grid[row][column];
+  }};
+  auto isDigit{
+      [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }};
+
+  int64_t partSum{0};
+  // The numbers around each `*`, keyed by its cell
+  std::vector<std::pair<std::pair<int64_t, int64_t>, int64_t>> gearNumbers;
+
+  for (int64_t row{0}; row < height; row++) {
+    const int64_t width{static_cast<int64_t>(grid[row].size())};
+    for (int64_t column{0}; column < width; column++) {
+      if (!isDigit(grid[row][column])) {
+        continue;
+      }
+      int64_t end{column};
+      while (end < width && isDigit(grid[row][end])) {
+        end++;
+      }
+      const int64_t value{std::stoll(grid[row].substr(column, end - column))};
+
+      bool touchesSymbol{false};
+      for (int64_t r{row - 1}; r <= row + 1; r++) {
+        for (int64_t c{column - 1}; c <= end; c++) {
+          const char cell{at(r, c)};
+          touchesSymbol = touchesSymbol || (cell != '.' && !isDigit(cell));
+          if (cell == '*') {
+            gearNumbers.push_back({{r, c}, value});
+          }
+        }
+      }
+      partSum += touchesSymbol ? value : 0;
+      column = end;
+    }
+  }
+
+  std::sort(gearNumbers.begin(), gearNumbers.end());
+  int64_t gearSum{0};
+  for (size_t i{0}; i < gearNumbers.size();) {
+    size_t next{i};
+    while (next < gearNumbers.size() &&
+           gearNumbers[next].first == gearNumbers[i].first) {
+      next++;
+    }
+    if (next - i == 2) {
+      gearSum += gearNumbers[i].second * gearNumbers[i + 1].second;
+    }
+    i = next;
+  }
+
+  return "Part A: The schematic sum is: " + std::to_string(partSum) +
+         "\nPart B: The cumulative gear ratios are: " +
+         std::to_string(gearSum) + "\n";
+}
+
+std::string referenceDay4(const std::string &input) {
+  const std::vector<std::string> lines{splitLines(input)};
+  std::vector<int64_t> copies(lines.size(), 1);
+  int64_t score{0};
+  int64_t nCopies{0};
+
+  for (size_t card{0}; card < lines.size(); card++) {
+    const std::string &line{lines[card]};
+    const size_t colon{line.find(':')};
+    const size_t bar{line.find('|')};
+    const std::vector<int64_t> winning{
+        numbersIn(line.substr(colon + 1, bar - colon - 1))};
+    const std::set<int64_t> winningSet(winning.begin(), winning.end());
+
+    int64_t nMatches{0};
+    for (const int64_t number : numbersIn(line.substr(bar + 1))) {
+      nMatches += static_cast<int64_t>(winningSet.count(number));
+    }
+
+    score += nMatches > 0 ? int64_t{1} << (nMatches - 1) : 0;
+    nCopies += copies[card];
+
+    // Like the original solution, a card whose copies would run past the
+    // last card wins none
+    if (card + nMatches >= lines.size()) {
+      continue;
+    }
+    for (size_t next{card + 1}; next <= card + nMatches; next++) {
+      copies[next] += copies[card];
+    }
+  }
+
+  return "Part A: The cumulative score is: " + std::to_string(score) +
+         "\nPart B: The cumulative number of copies is: " +
+         std::to_string(nCopies) + "\n";
+}
+
+std::string referenceDay5(const std::string &input) {
+  /**
+   * Part B splits each interval of seeds at every range of a map, one range
+   * at a time.
+   **/
+  const std::vector<std::string> lines{splitLines(input)};
+  const std::vector<int64_t> seeds{numbersIn(lines.front().substr(6))};
+
+  std::vector<std::vector<std::vector<int64_t>>> maps;
+  for (size_t i{1}; i < lines.size(); i++) {
+    if (lines[i].ends_with("map:")) {
+      maps.emplace_back();
+    } else if (!lines[i].empty()) {
+      maps.back().push_back(numbersIn(lines[i]));
+    }
+  }
+
+  int64_t minimumA{std::numeric_limits<int64_t>::max()};
+  for (int64_t value : seeds) {
+    for (const auto &ranges : maps) {
+      for (const std::vector<int64_t> &range : ranges) {
+        if (value >= range[1] && value < range[1] + range[2]) {
+          value += range[0] - range[1];
+          break;
+        }
+      }
+    }
+    minimumA = std::min(minimumA, value);
+  }
+
+  // Intervals as [start, end)
+  std::vector<std::pair<int64_t, int64_t>> intervals;
+  for (size_t i{0}; i < seeds.size(); i += 2) {
+    intervals.emplace_back(seeds[i], seeds[i] + seeds[i + 1]);
+  }
+  for (const auto &ranges : maps) {
+    std::vector<std::pair<int64_t, int64_t>> mapped;
+    for (const std::vector<int64_t> &range : ranges) {
+      const int64_t source{range[1]};
+      const int64_t sourceEnd{range[1] + range[2]};
+      std::vector<std::pair<int64_t, int64_t>> unmapped;
+      for (const auto &[start, end] : intervals) {
+        const int64_t overlapStart{std::max(start, source)};
+        const int64_t overlapEnd{std::min(end, sourceEnd)};
+        if (overlapStart >= overlapEnd) {
+          unmapped.emplace_back(start, end);
+          continue;
+        }
+        mapped.emplace_back(overlapStart + range[0] - source,
+                            overlapEnd + range[0] - source);
+        if (start < overlapStart) {
+          unmapped.emplace_back(start, overlapStart);
+        }
+        if (overlapEnd < end) {
+          unmapped.emplace_back(overlapEnd, end);
+        }
+      }
+      intervals = std::move(unmapped);
+    }
+    intervals.insert(intervals.end(), mapped.begin(), mapped.end());
+  }
+
+  const int64_t minimumB{
+      std::min_element(intervals.begin(), intervals.end())->first};
+
+  return "Part A: The minimum location is: " + std::to_string(minimumA) +
+         "\nPart B: The minimum location is: " + std::to_string(minimumB) +
+         "\n";
+}
+
+TEST(generateDay1MatchesReference) {
+  for (uint64_t seed{1}; seed <= 3; seed++) {
+    const std::string input{generateDay1Input(500, seed)};
+    CHECK_EQUAL(solve("day1", input), referenceDay1(input));
+  }
+}
+
+TEST(generateDay2MatchesReference) {
+  for (uint64_t seed{1}; seed <= 3; seed++) {
+    const std::string input{generateDay2Input(300, seed)};
+    CHECK_EQUAL(solve("day2", input), referenceDay2(input));
+  }
+}
+
+TEST(generateDay3MatchesReference) {
+  for (uint64_t seed{1}; seed <= 3; seed++) {
+    for (const double density : {0.15, 0.5}) {
+      const std::string input{generateDay3Input(60, 80, density, seed)};
+      CHECK_EQUAL(solve("day3", input), referenceDay3(input));
+    }
+  }
+}
+
+TEST(generateDay4MatchesReference) {
+  for (uint64_t seed{1}; seed <= 3; seed++) {
+    const std::string input{generateDay4Input(400, 10, 0.1, seed)};
+    CHECK_EQUAL(solve("day4", input), referenceDay4(input));
+  }
+}
+
+TEST(generateDay5MatchesReference) {
+  for (uint64_t seed{1}; seed <= 3; seed++) {
+    const std::string input{generateDay5Input(40, 10, seed)};
+    CHECK_EQUAL(solve("day5", input), referenceDay5(input));
+  }
+}
+
+TEST(generateLargeDay5MatchesReference) {
+  // Maps large enough to be built on the pool, straddling line batches
+  const std::string input{generateDay5Input(4200, 4, 1)};
+  CHECK_EQUAL(solve("day5", input), referenceDay5(input));
+}
+
+TEST(generateRejectsUnknownOptions) {
+  CHECK_EQUAL(runCommand("generate/generate day1 lines=5 >/dev/null"), 0);
+  CHECK_EQUAL(runCommand("generate/generate day1 line=5 >/dev/null 2>&1"), 1);
+  CHECK_EQUAL(
+      runCommand("generate/generate day4 cards=5 ranges=3 >/dev/null 2>&1"),
+      1);
+}
+
+} // namespace
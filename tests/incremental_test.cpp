@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "advent_support/incremental.h"
+#include "advent_support/solver.h"
+#include "test.h"
+
+// `BlockCache` re-solves exactly the blocks that changed, and the incremental
+// solvers answer the same as the plain ones whatever happened to the input
+// or the cache in between
+
+namespace day1 {
+void solveIncremental(const std::string &filename, std::ostream &out);
+} // namespace day1
+
+namespace day4 {
+void solveIncremental(const std::string &filename, std::ostream &out);
+} // namespace day4
+
+namespace {
+
+constexpr int64_t BLOCK_SIZE{BlockCache::BLOCK_SIZE};
+
+std::vector<std::string> numberedLines(int64_t nLines) {
+  std::vector<std::string> retLines;
+  for (int64_t i{0}; i < nLines; i++) {
+    retLines.push_back("line " + std::to_string(i));
+  }
+  return retLines;
+}
+
+// Each block's value is its number of lines
+BlockCache::BlockSolver countLines() {
+  return [](int64_t begin, int64_t end) {
+    return std::vector<int64_t>{end - begin};
+  };
+}
+
+// A fresh cache for `input`, refreshed with `lines` and saved, returning the
+// index of the first block it solved again and how many it did
+std::pair<int64_t, int64_t> refresh(const std::string &input,
+                                    const std::vector<std::string> &lines) {
+  BlockCache cache{input, "test", 1};
+  const int64_t firstChanged{cache.refresh(lines, countLines())};
+  CHECK(cache.save());
+  CHECK_EQUAL(cache.nBlocks(), (static_cast<int64_t>(lines.size()) +
+                                BLOCK_SIZE - 1) /
+                                   BLOCK_SIZE);
+  return {firstChanged, cache.nRecomputed()};
+}
+
+std::string solveIncremental(const std::string &day,
+                             const std::string &filename) {
+  std::ostringstream out;
+  (day == "day1" ? day1::solveIncremental : day4::solveIncremental)(filename,
+                                                                    out);
+  return out.str();
+}
+
+std::string solve(const std::string &day, const std::string &filename) {
+  std::ostringstream out;
+  registeredSolvers().at(day).solve(filename, out);
+  return out.str();
+}
+
+// The names of the files in `directory`
+std::vector<std::string> listFiles(const std::string &directory) {
+  std::vector<std::string> retNames;
+  for (const auto &entry : std::filesystem::directory_iterator{directory}) {
+    retNames.push_back(entry.path().filename().string());
+  }
+  std::sort(retNames.begin(), retNames.end());
+  return retNames;
+}
+
+TEST(incrementalResolvesChangedBlocks) {
+  const TemporaryDirectory directory;
+  const std::string input{directory.path("input.txt")};
+  std::vector<std::string> lines{numberedLines(3 * BLOCK_SIZE + 10)};
+
+  CHECK(refresh(input, lines) == std::make_pair(int64_t{0}, int64_t{4}));
+  CHECK(refresh(input, lines) == std::make_pair(int64_t{4}, int64_t{0}));
+  CHECK(listFiles(directory.path("")) ==
+        std::vector<std::string>{"input.txt.cache"});
+
+  // An edit in the middle
+  lines[BLOCK_SIZE + 5] += " edited";
+  CHECK(refresh(input, lines) == std::make_pair(int64_t{1}, int64_t{1}));
+
+  // An append grows the last block and adds a new one
+  for (const std::string &line : numberedLines(BLOCK_SIZE)) {
+    lines.push_back("appended " + line);
+  }
+  CHECK(refresh(input, lines) == std::make_pair(int64_t{3}, int64_t{2}));
+
+  // A truncation in the middle of a block
+  lines.resize(2 * BLOCK_SIZE - 1);
+  CHECK(refresh(input, lines) == std::make_pair(int64_t{1}, int64_t{1}));
+
+  // And back to the blocks that were cached before it
+  lines.resize(BLOCK_SIZE);
+  CHECK(refresh(input, lines) == std::make_pair(int64_t{1}, int64_t{0}));
+}
+
+TEST(incrementalIgnoresCorruptCaches) {
+  const TemporaryDirectory directory;
+  const std::string input{directory.path("input.txt")};
+  const std::vector<std::string> lines{numberedLines(2 * BLOCK_SIZE + 1)};
+
+  for (const std::string contents :
+       {"", "garbage", "advent-block-cache-v1 test 1024\n12 3 1 2 3\n",
+        "advent-block-cache-v1 test 1024\n12 1 1024\n13 1 1000\n14 1 1\n",
+        "advent-block-cache-v1 other 1024\n", "advent-block-cache-v0"}) {
+    directory.write("input.txt.cache", contents);
+    BlockCache cache{input, "test", 1};
+    cache.refresh(lines, countLines());
+    CHECK_EQUAL(cache.nRecomputed(), 3);
+    CHECK_EQUAL(cache.values(1).front(), BLOCK_SIZE);
+    CHECK_EQUAL(cache.values(2).front(), 1);
+  }
+
+  // A cache cut off in the middle of a block keeps the blocks before it
+  refresh(input, lines);
+  std::string contents;
+  {
+    std::ifstream file{directory.path("input.txt.cache")};
+    contents.assign(std::istreambuf_iterator<char>{file}, {});
+  }
+  const size_t lastBlock{contents.rfind('\n', contents.size() - 2) + 1};
+  directory.write("input.txt.cache", contents.substr(0, lastBlock + 2));
+  CHECK(refresh(input, lines) == std::make_pair(int64_t{2}, int64_t{1}));
+}
+
+TEST(incrementalSolversMatchPlainSolvers) {
+  const TemporaryDirectory directory;
+  const std::string day1Line{"two1nine\n"};
+  const std::string day4Line{"Card 1: 41 48 83 | 83 86  6 31 17  9 48 53\n"};
+
+  for (const std::string day : {"day1", "day4"}) {
+    const std::string &line{day == "day1" ? day1Line : day4Line};
+    const std::string otherLine{day == "day1" ? "a1b2c3\n"
+                                              : "Card 2: 1 2 | 3 4\n"};
+    auto joinLines{[&line, &otherLine](int64_t nLines) {
+      std::string retContents;
+      for (int64_t i{0}; i < nLines; i++) {
+        retContents += i % 7 == 0 ? line : otherLine;
+      }
+      return retContents;
+    }};
+    const std::string contents{joinLines(2 * BLOCK_SIZE + 100)};
+    const std::string input{directory.path(day + ".txt")};
+
+    const std::vector<std::string> edits{
+        contents,
+        // An edit in the middle
+        joinLines(BLOCK_SIZE + 3) + line + line +
+            contents.substr(joinLines(BLOCK_SIZE + 5).size()),
+        // A last line without a trailing newline
+        contents.substr(0, contents.size() - 1),
+        // Appended to that line
+        contents.substr(0, contents.size() - 1) + "\n" + line + line,
+        // Truncated into the first block
+        joinLines(100)};
+
+    for (const std::string &edit : edits) {
+      directory.write(day + ".txt", edit);
+      CHECK_EQUAL(solveIncremental(day, input), solve(day, input));
+    }
+  }
+}
+
+TEST(incrementalRunsWithoutWritableCache) {
+  const TemporaryDirectory directory;
+  const std::string input{directory.write("input.txt", "1abc2\npqr3stu8vwx\n")};
+  const std::string expected{solve("day1", input)};
+
+  // A cache path that cannot be replaced, even by root
+  std::filesystem::create_directories(directory.path("input.txt.cache/x"));
+  CHECK_EQUAL(solveIncremental("day1", input), expected);
+  CHECK(listFiles(directory.path("")) ==
+        (std::vector<std::string>{"input.txt", "input.txt.cache"}));
+  std::filesystem::remove_all(directory.path("input.txt.cache"));
+
+  // A read-only directory
+  std::filesystem::permissions(directory.path(""),
+                               std::filesystem::perms::owner_write,
+                               std::filesystem::perm_options::remove);
+  CHECK_EQUAL(solveIncremental("day1", input), expected);
+  if (access(directory.path("").c_str(), W_OK) != 0) {
+    CHECK(listFiles(directory.path("")) ==
+          std::vector<std::string>{"input.txt"});
+  }
+  std::filesystem::permissions(directory.path(""),
+                               std::filesystem::perms::owner_write,
+                               std::filesystem::perm_options::add);
+}
+
+} // namespace
@@ -0,0 +1,51 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "day5/range_mapping.h"
+#include "test.h"
+
+// `RangeMapping` maps values like a scan over its ranges in insertion order
+// does, whether it scans them itself or binary searches them
+
+namespace {
+
+int64_t referenceMap(const RangeMapping &mapping, const int64_t value) {
+  for (const auto &[source, destination, length] : mapping.ranges()) {
+    if (value >= source && value < source + length) {
+      return destination + (value - source);
+    }
+  }
+  return value;
+}
+
+TEST(rangeMappingMapsValues) {
+  std::mt19937_64 random{37};
+
+  // Both sides of the size at which `mapValue` stops scanning
+  for (const int64_t nRanges : {0, 1, 2, 31, 127, 128, 129, 500, 4000}) {
+    RangeMapping mapping;
+    int64_t start{static_cast<int64_t>(random() % 10)};
+    for (int64_t i{0}; i < nRanges; i++) {
+      const int64_t length{1 + static_cast<int64_t>(random() % 20)};
+      mapping.addRange(start, static_cast<int64_t>(random() % 100000), length);
+      // Adjacent ranges as well as gaps between them
+      start += length + static_cast<int64_t>(random() % 3);
+    }
+    mapping.sortRanges();
+
+    std::vector<int64_t> values;
+    for (int64_t value{-2}; value < start + 5; value++) {
+      CHECK_EQUAL(mapping.mapValue(value), referenceMap(mapping, value));
+      values.push_back(value);
+    }
+
+    std::vector<int64_t> mapped;
+    mapping.mapSortedValues(values, mapped);
+    for (size_t i{0}; i < values.size(); i++) {
+      CHECK_EQUAL(mapped[i], referenceMap(mapping, values[i]));
+    }
+  }
+}
+
+} // namespace
@@ -0,0 +1,28 @@
+#include <string>
+
+#include "test.h"
+
+namespace {
+
+TEST(runnerRunsManifest) {
+  const TemporaryDirectory directory;
+  const std::string input{
+      directory.write("day1.txt", "1abc2\npqr3stu8vwx\na1b2c3d4e5f\n")};
+  const std::string manifest{directory.write(
+      "manifest.txt", "# A comment\n\nday1 " + input + "\n")};
+
+  CHECK_EQUAL(runCommand("runner/runner -j 2 " + manifest + " >/dev/null"), 0);
+}
+
+TEST(runnerRejectsBadThreadCounts) {
+  const TemporaryDirectory directory;
+  const std::string manifest{directory.write("manifest.txt", "")};
+
+  for (const std::string threads : {"", "0", "-3", "four", "4x"}) {
+    CHECK_EQUAL(runCommand("runner/runner " + manifest + " -j " + threads +
+                           " >/dev/null 2>&1"),
+                1);
+  }
+}
+
+} // namespace
@@ -0,0 +1,281 @@
+#include <csignal>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "advent_support/solver.h"
+#include "day5/day5.h"
+#include "test.h"
+
+// The solver server answers over its socket what the solvers answer in
+// process, and notices when the inputs it keeps warm change
+
+namespace {
+
+class ServerProcess {
+  /**
+   * `server/server` listening on a socket in `directory`, stopped on
+   * destruction.
+   **/
+public:
+  explicit ServerProcess(const TemporaryDirectory &directory)
+      : mSocketPath{directory.path("advent.sock")}, mPid{fork()} {
+    if (mPid == 0) {
+      // Its progress messages would only clutter the test report
+      dup2(open("/dev/null", O_WRONLY), STDERR_FILENO);
+      execl("server/server", "server/server", "-j", "2", mSocketPath.c_str(),
+            static_cast<char *>(nullptr));
+      _exit(127);
+    }
+  }
+
+  ~ServerProcess() {
+    kill(mPid, SIGTERM);
+    waitpid(mPid, nullptr, 0);
+  }
+
+  ServerProcess(const ServerProcess &) = delete;
+  ServerProcess &operator=(const ServerProcess &) = delete;
+
+  const std::string &socketPath() const { return mSocketPath; }
+
+private:
+  std::string mSocketPath;
+  pid_t mPid;
+};
+
+class Client {
+  /**
+   * A connection to the server, retried until it listens.
+   **/
+public:
+  explicit Client(const ServerProcess &server)
+      : mFd{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)} {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    server.socketPath().copy(address.sun_path, sizeof(address.sun_path) - 1);
+
+    for (int32_t attempt{0};
+         connect(mFd, reinterpret_cast<const sockaddr *>(&address),
+                 sizeof(address)) < 0;
+         attempt++) {
+      if (attempt == 500) {
+        throw std::runtime_error("Error connecting to the server");
+      }
+      usleep(10 * 1000);
+    }
+  }
+
+  ~Client() { close(mFd); }
+
+  Client(const Client &) = delete;
+  Client &operator=(const Client &) = delete;
+
+  void send(const std::string &data) const {
+    for (size_t offset{0}; offset < data.size();) {
+      const ssize_t nSent{::send(mFd, data.data() + offset,
+                                 data.size() - offset, MSG_NOSIGNAL)};
+      if (nSent <= 0) {
+        throw std::runtime_error("Error writing to the server");
+      }
+      offset += nSent;
+    }
+  }
+
+  // The next response, as `ok|error` and its body. `closed` if the server
+  // hung up instead
+  std::pair<std::string, std::string> receive() {
+    while (mReceived.find('\n') == std::string::npos) {
+      if (!receiveMore()) {
+        return {"closed", ""};
+      }
+    }
+
+    std::istringstream header{mReceived.substr(0, mReceived.find('\n'))};
+    std::string status;
+    double latencyMs{0};
+    size_t bodySize{0};
+    header >> status >> latencyMs >> bodySize;
+    const size_t bodyStart{mReceived.find('\n') + 1};
+
+    while (mReceived.size() < bodyStart + bodySize) {
+      if (!receiveMore()) {
+        return {"closed", ""};
+      }
+    }
+    std::string body{mReceived.substr(bodyStart, bodySize)};
+    mReceived.erase(0, bodyStart + bodySize);
+    return {status, body};
+  }
+
+  // The body of the response to `request`, which has to succeed
+  std::string request(const std::string &request) {
+    send(request);
+    const auto [status, body]{receive()};
+    CHECK_EQUAL(status, "ok");
+    return body;
+  }
+
+private:
+  bool receiveMore() {
+    char chunk[4096];
+    const ssize_t nReceived{recv(mFd, chunk, sizeof(chunk), 0)};
+    if (nReceived <= 0) {
+      return false;
+    }
+    mReceived.append(chunk, nReceived);
+    return true;
+  }
+
+  int32_t mFd;
+  std::string mReceived{};
+};
+
+std::string solve(const std::string &day, const std::string &filename) {
+  std::ostringstream out;
+  registeredSolvers().at(day).solve(filename, out);
+  return out.str();
+}
+
+// The `<kind>: ...` line of a `stats` report
+std::string statsLine(const std::string &stats, const std::string &kind) {
+  std::istringstream lines{stats};
+  for (std::string line; std::getline(lines, line);) {
+    if (line.starts_with(kind + ": ")) {
+      return line.substr(0, line.find(" warm") + 5);
+    }
+  }
+  return "";
+}
+
+const std::string ALMANAC{"seeds: 79 14 55 13\n"
+                          "\n"
+                          "seed-to-soil map:\n"
+                          "50 98 2\n"
+                          "52 50 48\n"
+                          "\n"
+                          "soil-to-fertilizer map:\n"
+                          "0 15 37\n"
+                          "37 52 2\n"
+                          "39 0 15\n"};
+
+TEST(serverSolvesChangedFiles) {
+  const TemporaryDirectory directory;
+  const ServerProcess server{directory};
+  Client client{server};
+
+  const std::string input{directory.write("day1.txt", "1abc2\na1b2c3d4e5f\n")};
+  const std::string firstAnswer{solve("day1", input)};
+  CHECK_EQUAL(client.request("solve day1 " + input + "\n"), firstAnswer);
+  CHECK_EQUAL(client.request("solve day1 " + input + "\n"), firstAnswer);
+
+  // A new version of the file is solved again, however soon it changed
+  directory.write("day1.txt", "1abc2\na1b2c3d4e5f\ntreb7uchet\n");
+  const std::string secondAnswer{solve("day1", input)};
+  CHECK(secondAnswer != firstAnswer);
+  CHECK_EQUAL(client.request("solve day1 " + input + "\n"), secondAnswer);
+
+  CHECK_EQUAL(statsLine(client.request("stats\n"), "solve"),
+              "solve: 3 requests, 1 warm");
+}
+
+TEST(serverSolvesInlineInputs) {
+  const TemporaryDirectory directory;
+  const ServerProcess server{directory};
+  Client client{server};
+
+  // Inputs of the same size, so that only their digest tells them apart
+  const std::string first{"1abc2\n"};
+  const std::string second{"7abc3\n"};
+  const std::string firstAnswer{solve("day1", directory.write("1", first))};
+  const std::string secondAnswer{solve("day1", directory.write("2", second))};
+
+  // Several requests in a single write, answered in order
+  client.send("solve-inline day1 6\n" + first + "solve-inline day1 6\n" +
+              second + "solve-inline day1 6\n" + first);
+  CHECK_EQUAL(client.receive().second, firstAnswer);
+  CHECK_EQUAL(client.receive().second, secondAnswer);
+  CHECK_EQUAL(client.receive().second, firstAnswer);
+
+  CHECK_EQUAL(statsLine(client.request("stats\n"), "solve-inline"),
+              "solve-inline: 3 requests, 1 warm");
+}
+
+TEST(serverAnswersQueriesOnChangedAlmanacs) {
+  const TemporaryDirectory directory;
+  const ServerProcess server{directory};
+  Client client{server};
+
+  const std::string queries{"seed 79\nlocation 81\nminimum 79 14 55 13\n"};
+  const std::string almanac{directory.write("almanac.txt", ALMANAC)};
+  const std::string firstAnswers{
+      day5::answerQueries(day5::composeAlmanac(almanac), queries)};
+  const std::string request{"query " + almanac + " " +
+                            std::to_string(queries.size()) + "\n" + queries};
+  CHECK_EQUAL(client.request(request), firstAnswers);
+
+  directory.write("almanac.txt", ALMANAC + "\nfertilizer-to-water map:\n"
+                                           "49 53 8\n0 11 42\n");
+  const std::string secondAnswers{
+      day5::answerQueries(day5::composeAlmanac(almanac), queries)};
+  CHECK(secondAnswers != firstAnswers);
+  CHECK_EQUAL(client.request(request), secondAnswers);
+}
+
+TEST(serverReportsErrors) {
+  const TemporaryDirectory directory;
+  const ServerProcess server{directory};
+  Client client{server};
+
+  const std::string missing{directory.path("missing.txt")};
+  const std::vector<std::string> requests{
+      "solve day99 input.txt\n", "solve day1\n",
+      "solve day1 " + missing + "\n", "solve-inline day1 x\n",
+      "query\n", "frobnicate 1 2\n", "query " + missing + " 0\n"};
+  for (const std::string &request : requests) {
+    client.send(request);
+    CHECK_EQUAL(client.receive().first, "error");
+  }
+
+  // The connection is still good
+  CHECK_EQUAL(client.request("solve-inline day1 6\n1abc2\n"),
+              "Part A: The calibration value is: 12\n"
+              "Part B: The calibration value is: 12\n");
+}
+
+TEST(serverDropsOverlongRequestLines) {
+  const TemporaryDirectory directory;
+  const ServerProcess server{directory};
+  Client client{server};
+
+  client.send(std::string(64 * 1024, 'x'));
+  CHECK_EQUAL(client.receive().first, "closed");
+
+  // Other clients are still served
+  Client other{server};
+  CHECK_EQUAL(other.request("solve-inline day1 6\n1abc2\n"),
+              "Part A: The calibration value is: 12\n"
+              "Part B: The calibration value is: 12\n");
+}
+
+TEST(serverRejectsBadThreadCounts) {
+  const TemporaryDirectory directory;
+  const std::string socketPath{directory.path("advent.sock")};
+
+  for (const std::string threads : {"", "0", "-3", "four", "4x"}) {
+    CHECK_EQUAL(runCommand("server/server " + socketPath + " -j " + threads +
+                           " 2>/dev/null"),
+                1);
+  }
+}
+
+} // namespace
@@ -0,0 +1,112 @@
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+
+#include "test.h"
+
+namespace {
+
+struct RegisteredTest {
+  const char *name;
+  TestFunction function;
+};
+
+std::vector<RegisteredTest> &registeredTests() {
+  // Constructed on first use, the registrations run during static
+  // initialization in no particular order
+  static std::vector<RegisteredTest> tests;
+  return tests;
+}
+
+// The failures of the running test
+int64_t nFailures{0};
+
+} // namespace
+
+TestRegistration::TestRegistration(const char *name,
+                                   const TestFunction function) {
+  registeredTests().push_back({name, function});
+}
+
+void failTest(const char *file, const int32_t line,
+              const std::string &message) {
+  std::cerr << file << ":" << line << ": " << message << std::endl;
+  nFailures++;
+}
+
+TemporaryDirectory::TemporaryDirectory()
+    : mPath{(std::filesystem::temp_directory_path() / "advent-test-XXXXXX")
+                .string()} {
+  if (mkdtemp(mPath.data()) == nullptr) {
+    throw std::runtime_error("Error creating a temporary directory");
+  }
+}
+
+TemporaryDirectory::~TemporaryDirectory() {
+  std::error_code error;
+  std::filesystem::remove_all(mPath, error);
+}
+
+std::string TemporaryDirectory::path(const std::string &name) const {
+  return mPath + "/" + name;
+}
+
+std::string TemporaryDirectory::write(const std::string &name,
+                                      const std::string &contents) const {
+  const std::string retPath{path(name)};
+  std::ofstream file{retPath, std::ios::binary | std::ios::trunc};
+  file << contents;
+  if (!file) {
+    throw std::runtime_error("Error writing file: " + retPath);
+  }
+  return retPath;
+}
+
+int32_t runCommand(const std::string &command) {
+  const int32_t status{std::system(command.c_str())};
+  if (status < 0 || !WIFEXITED(status)) {
+    return -1;
+  }
+  return WEXITSTATUS(status);
+}
+
+int32_t main(int argc, char *argv[]) {
+  const std::vector<std::string> prefixes(argv + 1, argv + argc);
+  int64_t nRun{0};
+  int64_t nFailed{0};
+
+  for (const RegisteredTest &test : registeredTests()) {
+    const std::string name{test.name};
+    bool selected{prefixes.empty()};
+    for (const std::string &prefix : prefixes) {
+      selected = selected || name.starts_with(prefix);
+    }
+    if (!selected) {
+      continue;
+    }
+
+    nFailures = 0;
+    try {
+      test.function();
+    } catch (const std::exception &exception) {
+      failTest(test.name, 0, std::string{"Uncaught exception: "} +
+                                 exception.what());
+    }
+
+    nRun++;
+    nFailed += nFailures > 0 ? 1 : 0;
+    std::cout << (nFailures > 0 ? "FAIL " : "ok   ") << name << std::endl;
+  }
+
+  std::cout << nRun - nFailed << " of " << nRun << " tests passed"
+            << std::endl;
+  return nFailed > 0 || nRun == 0 ? 1 : 0;
+}
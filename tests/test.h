@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+// A minimal test harness. `TEST(name) { ... }` defines a test and registers
+// it, and `CHECK` and `CHECK_EQUAL` record a failure and carry on with the
+// test. `tests/tests [<prefix> ...]` runs every test, or those whose name
+// starts with one of the prefixes, and exits non-zero if any of them failed.
+//
+// The tests run from the repository root, as `make test` does, which is
+// where they find the binaries they drive.
+
+using TestFunction = void (*)();
+
+class TestRegistration {
+public:
+  TestRegistration(const char *name, TestFunction function);
+};
+
+// Record a failure of the running test
+void failTest(const char *file, int32_t line, const std::string &message);
+
+#define TEST(name)                                                             \
+  void name();                                                                 \
+  const TestRegistration name##Registration{#name, name};                      \
+  void name()
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      failTest(__FILE__, __LINE__, #condition);                                \
+    }                                                                          \
+  } while (false)
+
+#define CHECK_EQUAL(actual, expected)                                          \
+  do {                                                                         \
+    const auto &checkedActual{actual};                                         \
+    const auto &checkedExpected{expected};                                     \
+    if (!(checkedActual == checkedExpected)) {                                 \
+      std::ostringstream message;                                              \
+      message << #actual << " == " << #expected << "\n  actual:   "            \
+              << checkedActual << "\n  expected: " << checkedExpected;         \
+      failTest(__FILE__, __LINE__, message.str());                             \
+    }                                                                          \
+  } while (false)
+
+class TemporaryDirectory {
+  /**
+   * A fresh directory under `$TMPDIR`, removed with everything in it on
+   * destruction.
+   **/
+public:
+  TemporaryDirectory();
+  ~TemporaryDirectory();
+
+  TemporaryDirectory(const TemporaryDirectory &) = delete;
+  TemporaryDirectory &operator=(const TemporaryDirectory &) = delete;
+
+  // The path of `name` inside the directory
+  std::string path(const std::string &name) const;
+
+  // Write `contents` to `name`, returning its path
+  std::string write(const std::string &name, const std::string &contents) const;
+
+private:
+  std::string mPath;
+};
+
+// Run `command` with `/bin/sh`, returning its exit status
+int32_t runCommand(const std::string &command);